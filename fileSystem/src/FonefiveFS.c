@@ -70,12 +70,8 @@ int fs_format(const char *const fname)
 		return -1;
 	}
 	
-	bool success = true;
-	for(size_t i = INODE_BLOCK_OFFSET; i < (INODE_BLOCK_OFFSET + INODE_BLOCK_TOTAL); ++i) {
-		success &= block_store_request(bs, i);
-	}
-
-	if(!success) {// error checking request
+	//grab the whole inode table in one go
+	if(!block_store_request_range(bs, INODE_BLOCK_OFFSET, INODE_BLOCK_TOTAL)) {// error checking request
 		fprintf(stderr, "Couldn't request inode table. Block store states: %s\n", block_store_strerror(block_store_errno()));
 		block_store_destroy(bs, BS_FLUSH);
 		return -1;
@@ -202,6 +198,42 @@ bool write_partial_block(const F15FS_t *const fs, const block_ptr_t block, const
             block_store_errno() == BS_OK);
 }
 
+// Grabs count blocks for a file and puts their ids in blocks
+// We try for a contiguous extent so files don't get scattered all over the store:
+//  First right at the goal (pass 0 for no goal, usually it's the block after the file's last one)
+//  Then anywhere block_store can find a run that long
+//  Then we give up on contiguous and take what we can get
+// Returns false IFF we couldn't get all of them (blocks will be zeroed and nothing held)
+bool allocate_blocks(const F15FS_t *const fs, size_t *const blocks, const size_t count, const size_t goal) {
+    if (fs && blocks && count) {
+        size_t first = 0;
+        if (BLOCK_IDX_VALID(goal) && block_store_request_range(fs->bs, goal, count)) {
+            first = goal;
+        } else {
+            first = block_store_allocate_range(fs->bs, count);
+        }
+        if (first) {
+            for (size_t i = 0; i < count; ++i) {
+                blocks[i] = first + i;
+            }
+            return true;
+        }
+        // Too fragmented (or full), one at a time it is
+        for (size_t i = 0; i < count; ++i) {
+            blocks[i] = block_store_allocate(fs->bs);
+            if (!blocks[i]) {
+                while (i) {
+                    block_store_release(fs->bs, blocks[--i]);
+                }
+                memset(blocks, 0x00, count * sizeof(size_t));
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
 // Given an fname and an inode, scan_directory will:
 //  Validate the fname pointer (and result struct)
 //  Load and validate that the specified inode is a file that 1: exists and 2: is a directory
@@ -748,8 +780,9 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
             // Score, this is easy
             if (file_inode->data_ptrs[data_itr->indices[0]] == 0) {
                 // need to make a new block, pointer is 0
-                new_block[0] = block_store_allocate(fs->bs);
-                if (new_block[0]) {
+                // (try to put it right after the previous one)
+                if (allocate_blocks(fs, new_block, 1,
+                                    data_itr->indices[0] ? file_inode->data_ptrs[data_itr->indices[0] - 1] + 1 : 0)) {
                     // Cool, we got a fresh block, update the inode
                     file_inode->data_ptrs[data_itr->indices[0]] = new_block[0];
                     if (write_inode(fs, data_itr->inode, file_inode)) {
@@ -771,9 +804,9 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
             if (file_inode->data_ptrs[data_itr->indices[0]] == 0) {
                 // we need to make a fresh indirect and setup the first direct in it
                 // (we need two blocks!)
-                new_block[0] = block_store_allocate(fs->bs); // New indir block (need to write contents)
-                new_block[1] = block_store_allocate(fs->bs); // New data block (nothing to write)
-                if (new_block[0] && new_block[1]) {
+                // new_block[0] is the new indir block (need to write contents)
+                // new_block[1] is the new data block (nothing to write)
+                if (allocate_blocks(fs, new_block, 2, 0)) {
                     indir_block = calloc(sizeof(data_block_t), 1);
                     if (indir_block) {
                         file_inode->data_ptrs[data_itr->indices[0]] = new_block[0];
@@ -809,8 +842,8 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
                         // Ok, we have the indirect block (that already existed) loaded
                         if (!indir_block[data_itr->indices[1]]) {
                             // block does not exist, need to create it
-                            new_block[0] = block_store_allocate(fs->bs);
-                            if (new_block[0]) {
+                            if (allocate_blocks(fs, new_block, 1,
+                                                data_itr->indices[1] ? indir_block[data_itr->indices[1] - 1] + 1 : 0)) {
                                 indir_block[data_itr->indices[1]] = new_block[0];
                                 if (write_block(fs, file_inode->data_ptrs[data_itr->indices[0]], indir_block)) {
                                     // All good?
@@ -849,10 +882,10 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
                 // Gotta make EVERYTHING
                 // ... copy/paste from indirect again
 
-                new_block[0] = block_store_allocate(fs->bs); // New dbl_indir block (need to write contents)
-                new_block[1] = block_store_allocate(fs->bs); // New indir block (need to write contents)
-                new_block[2] = block_store_allocate(fs->bs); // New data block (nothing to write)
-                if (new_block[0] && new_block[1] && new_block[2]) {
+                // new_block[0] is the new dbl_indir block (need to write contents)
+                // new_block[1] is the new indir block (need to write contents)
+                // new_block[2] is the new data block (nothing to write)
+                if (allocate_blocks(fs, new_block, 3, 0)) {
                     indir_block = calloc(sizeof(data_block_t), 1);
                     dbl_indir_block = calloc(sizeof(data_block_t), 1);
                     if (indir_block && dbl_indir_block) {
@@ -894,9 +927,9 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
                             // COPY/PASTE STARTS HERE
                             // we need to make a fresh indirect and setup the first direct in it
                             // (we need two blocks!)
-                            new_block[0] = block_store_allocate(fs->bs); // New indir block (need to write contents)
-                            new_block[1] = block_store_allocate(fs->bs); // New data block (nothing to write)
-                            if (new_block[0] && new_block[1]) {
+                            // new_block[0] is the new indir block (need to write contents)
+                            // new_block[1] is the new data block (nothing to write)
+                            if (allocate_blocks(fs, new_block, 2, 0)) {
                                 indir_block = calloc(sizeof(data_block_t), 1);
                                 if (indir_block) {
                                     indir_block[0] = new_block[1];
@@ -927,8 +960,8 @@ bool check_and_allocate_block(F15FS_t *const fs, data_itr_t *const data_itr, ino
                                     // Ok, we have the indirect block (that already existed) loaded
                                     if (!indir_block[data_itr->indices[2]]) {
                                         // block does not exist, need to create it
-                                        new_block[0] = block_store_allocate(fs->bs);
-                                        if (new_block[0]) {
+                                        if (allocate_blocks(fs, new_block, 1,
+                                                            data_itr->indices[2] ? indir_block[data_itr->indices[2] - 1] + 1 : 0)) {
                                             indir_block[data_itr->indices[2]] = new_block[0];
                                             if (success = write_block(fs, dbl_indir_block[data_itr->indices[1]], indir_block),
                                                     free(indir_block), success) {
@@ -0,0 +1,181 @@
+#include "../include/bitmap.h"
+#include "../src/bitmap.c"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+    Timing for the bitmap, not a test (it checks nothing, see test/test.c for that)
+
+    bitmap_bench [max_bits] > results.csv
+
+    Sizes go from 1K bits up to max_bits (default 1G, which is 128MB of bitmap) in steps of 32x
+    at each of a handful of fill densities, after a single-word (64 bit) map. The small maps are
+    there to catch per-call overhead (that's what block_store's allocations look like), anything
+    that isn't a few ns per word at 64 bits is a regression. One CSV row per op/size/fill on stdout:
+
+    op,bits,fill,ns_per_op,gb_per_s
+
+    ns_per_op is the time for one call. gb_per_s is how much of the bitmap that call got through,
+    so it's only filled in for the ops that walk the bitmap (ffs/ffz/find_zero_run count up to where they stopped).
+    set and test leave it blank, they touch one byte no matter how big the bitmap is.
+
+    Like the tester, this pulls the source in directly so it gets built with the bench's flags.
+*/
+
+// Each measurement keeps doubling its repetitions until it's run at least this long
+#define BENCH_MIN_NS 50000000.0
+// set/test calls per repetition
+#define BENCH_POINT_OPS 4096
+// The smallest map, before the 1K..max_bits series
+#define BENCH_SMALL_BITS 64
+// Run length find_zero_run looks for (a small allocation)
+#define BENCH_ZERO_RUN 8
+
+static const double bench_fills[] = {0.0, 0.01, 0.5, 0.99, 1.0};
+
+// Keeps the compiler from throwing away the results we don't look at
+static volatile size_t bench_sink;
+
+static double bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec * 1e9 + (double) now.tv_nsec;
+}
+
+// xorshift64, so fills are the same every run
+static uint64_t bench_rand(uint64_t *const state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void bench_fill(bitmap_t *const bitmap, const size_t bits, const double fill) {
+    bitmap_format(bitmap, fill >= 1.0 ? 0xFF : 0x00);
+    if (fill > 0.0 && fill < 1.0) {
+        uint64_t state = 0x0F15;
+        const uint64_t threshold = (uint64_t) (fill * (double) UINT64_MAX);
+        for (size_t bit = 0; bit < bits; ++bit) {
+            if (bench_rand(&state) < threshold) {
+                bitmap_set(bitmap, bit);
+            }
+        }
+    }
+}
+
+// Bits the point ops hit, spread over the whole bitmap (bits is always a power of two)
+static size_t bench_point(const size_t bits, const size_t idx) {
+    return (size_t) ((idx * 0x9E3779B97F4A7C15ull) >> 7) & (bits - 1);
+}
+
+static void bench_report(const char *const op, const size_t bits, const double fill, const double ns, const size_t bytes) {
+    if (bytes) {
+        printf("%s,%zu,%.2f,%.3f,%.3f\n", op, bits, fill, ns, (double) bytes / ns);
+    } else {
+        printf("%s,%zu,%.2f,%.3f,\n", op, bits, fill, ns);
+    }
+}
+
+static void bench_for_each_func(size_t bit, void *args) {
+    *((size_t *) args) += bit;
+}
+
+typedef enum {BENCH_SET, BENCH_TEST, BENCH_FFS, BENCH_FFZ, BENCH_FIND_ZERO_RUN, BENCH_TOTAL_SET, BENCH_FOR_EACH,
+              BENCH_INVERT, BENCH_OP_COUNT} BENCH_OP;
+
+static const char *const bench_op_names[BENCH_OP_COUNT] = {"set", "test", "ffs", "ffz", "find_zero_run", "total_set",
+                                                           "for_each", "invert"};
+
+// One call (or BENCH_POINT_OPS of them for set/test), returns how many calls that was
+static size_t bench_run_once(bitmap_t *const bitmap, const BENCH_OP op, const size_t bits, size_t *const bytes) {
+    size_t result = 0;
+    switch (op) {
+        case BENCH_SET:
+            for (size_t idx = 0; idx < BENCH_POINT_OPS; ++idx) {
+                bitmap_set(bitmap, bench_point(bits, idx));
+            }
+            return BENCH_POINT_OPS;
+        case BENCH_TEST:
+            for (size_t idx = 0; idx < BENCH_POINT_OPS; ++idx) {
+                result += bitmap_test(bitmap, bench_point(bits, idx));
+            }
+            bench_sink = result;
+            return BENCH_POINT_OPS;
+        case BENCH_FFS:
+        case BENCH_FFZ:
+            result = (op == BENCH_FFS) ? bitmap_ffs(bitmap) : bitmap_ffz(bitmap);
+            // Everything up to the word it stopped in
+            *bytes = (result == SIZE_MAX) ? bitmap_get_bytes(bitmap) : ((result >> 6) + 1) * 8;
+            bench_sink = result;
+            return 1;
+        case BENCH_FIND_ZERO_RUN:
+            result = bitmap_find_zero_run(bitmap, BENCH_ZERO_RUN, 0);
+            *bytes = (result == SIZE_MAX) ? bitmap_get_bytes(bitmap) : (((result + BENCH_ZERO_RUN - 1) >> 6) + 1) * 8;
+            bench_sink = result;
+            return 1;
+        case BENCH_TOTAL_SET:
+            bench_sink = bitmap_total_set(bitmap);
+            break;
+        case BENCH_FOR_EACH:
+            bitmap_for_each(bitmap, &bench_for_each_func, &result);
+            bench_sink = result;
+            break;
+        case BENCH_INVERT:
+            bitmap_invert(bitmap);
+            break;
+        default:
+            break;
+    }
+    *bytes = bitmap_get_bytes(bitmap);
+    return 1;
+}
+
+static void bench_op(bitmap_t *const bitmap, const BENCH_OP op, const size_t bits, const double fill) {
+    size_t reps = 1, calls = 0, bytes = 0, total_reps = 0;
+    double elapsed = 0.0;
+    while (elapsed < BENCH_MIN_NS) {
+        calls = 0;
+        const double start = bench_now_ns();
+        for (size_t rep = 0; rep < reps; ++rep) {
+            calls += bench_run_once(bitmap, op, bits, &bytes);
+        }
+        elapsed = bench_now_ns() - start;
+        total_reps += reps;
+        reps <<= 1;
+    }
+    // Put the fill back for the next op
+    if (op == BENCH_INVERT && (total_reps & 1)) {
+        bitmap_invert(bitmap);
+    }
+    bench_report(bench_op_names[op], bits, fill, elapsed / (double) calls, (op == BENCH_SET || op == BENCH_TEST) ? 0 : bytes);
+}
+
+int main(int argc, char **argv) {
+    size_t max_bits = ((size_t) 1) << 30;
+    if (argc > 1) {
+        max_bits = strtoull(argv[1], NULL, 0);
+    }
+    puts("op,bits,fill,ns_per_op,gb_per_s");
+    for (size_t bits = BENCH_SMALL_BITS; bits && bits <= max_bits; bits = (bits < (((size_t) 1) << 10)) ? (((size_t) 1) << 10) : bits << 5) {
+        bitmap_t *bitmap = bitmap_create(bits);
+        if (!bitmap) {
+            fprintf(stderr, "bitmap_bench: couldn't allocate %zu bits\n", bits);
+            return 1;
+        }
+        for (size_t fill = 0; fill < sizeof(bench_fills) / sizeof(bench_fills[0]); ++fill) {
+            // Filling a big one takes a while, so everything shares it and set goes last (it changes the fill)
+            bench_fill(bitmap, bits, bench_fills[fill]);
+            for (BENCH_OP op = BENCH_TEST; op < BENCH_OP_COUNT; ++op) {
+                bench_op(bitmap, op, bits, bench_fills[fill]);
+            }
+            bench_op(bitmap, BENCH_SET, bits, bench_fills[fill]);
+            fflush(stdout);
+        }
+        bitmap_destroy(bitmap);
+    }
+    return 0;
+}
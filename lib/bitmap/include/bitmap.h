@@ -10,10 +10,15 @@
 
 typedef struct bitmap bitmap_t;
 
+// Options for bitmap_map_file
+// POPULATE faults the whole file in up front (MAP_POPULATE, ignored where that doesn't exist)
+typedef enum {BITMAP_MAP_DEFAULT = 0x00, BITMAP_MAP_POPULATE = 0x01} BITMAP_MAP_FLAGS;
+
 // WARNING: Bit requests outside the bitmap and NULL pointers WILL result in a segfault
 // This was originally a high performance C++ library, so the C translation assumes you're using it right.
 
 // But is there really such a thing as a high-performance shared library?
+// (Not really, bitmap_inline.h has inline versions of the hot stuff)
 
 ///
 /// Sets requested bit in bitmap
@@ -44,12 +49,163 @@ bool bitmap_test(const bitmap_t *const bitmap, const size_t bit);
 ///
 void bitmap_flip(bitmap_t *const bitmap, const size_t bit);
 
+///
+/// Loads a word of the bitmap, bit b of word w is bit (w * 64 + b)
+///  Bits past the end of the bitmap are undetermined
+/// \param bitmap The bitmap
+/// \param word The word to load
+/// \return The word, 0 on error
+///
+uint64_t bitmap_load_word(const bitmap_t *const bitmap, const size_t word);
+
+///
+/// Stores a word of the bitmap, bit b of word w is bit (w * 64 + b)
+///  Bits past the end of the bitmap stay undetermined, whatever you store there
+/// \param bitmap The bitmap
+/// \param word The word to store
+/// \param value The new value
+///
+void bitmap_store_word(bitmap_t *const bitmap, const size_t word, const uint64_t value);
+
 ///
 /// Flips all bits in the bitmap
 /// \param bitmap The bitmap to invert
 ///
 void bitmap_invert(bitmap_t *const bitmap);
 
+///
+/// Sets all bits in the range [start, end)
+/// (does nothing if the range is empty or runs past the end)
+/// \param bitmap The bitmap
+/// \param start The first bit to set
+/// \param end One past the last bit to set
+///
+void bitmap_set_range(bitmap_t *const bitmap, const size_t start, const size_t end);
+
+///
+/// Clears all bits in the range [start, end)
+/// (does nothing if the range is empty or runs past the end)
+/// \param bitmap The bitmap
+/// \param start The first bit to clear
+/// \param end One past the last bit to clear
+///
+void bitmap_reset_range(bitmap_t *const bitmap, const size_t start, const size_t end);
+
+///
+/// Tests if all bits in the range [start, end) are set
+/// \param bitmap The bitmap
+/// \param start The first bit to test
+/// \param end One past the last bit to test
+/// \return true if every bit in the range is set, false otherwise or on error/empty range
+///
+bool bitmap_test_range_all(const bitmap_t *const bitmap, const size_t start, const size_t end);
+
+///
+/// Tests if any bit in the range [start, end) is set
+/// \param bitmap The bitmap
+/// \param start The first bit to test
+/// \param end One past the last bit to test
+/// \return true if at least one bit in the range is set, false otherwise or on error/empty range
+///
+bool bitmap_test_range_any(const bitmap_t *const bitmap, const size_t start, const size_t end);
+
+///
+/// Count the bits set in the range [start, end)
+/// \param bitmap The bitmap
+/// \param start The first bit to count
+/// \param end One past the last bit to count
+/// \return the number of bits set in the range, 0 on error/empty range
+///
+size_t bitmap_count_range(const bitmap_t *const bitmap, const size_t start, const size_t end);
+
+///
+/// Bitwise AND, in place (bitmap = bitmap & other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_and(bitmap_t *const bitmap, const bitmap_t *const other);
+
+///
+/// Bitwise AND, into a destination (dest = a & b)
+///  dest may be a or b
+/// \param dest The bitmap to write to
+/// \param a The first operand
+/// \param b The second operand
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_and_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b);
+
+///
+/// Bitwise OR, in place (bitmap = bitmap | other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_or(bitmap_t *const bitmap, const bitmap_t *const other);
+
+///
+/// Bitwise OR, into a destination (dest = a | b)
+///  dest may be a or b
+/// \param dest The bitmap to write to
+/// \param a The first operand
+/// \param b The second operand
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_or_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b);
+
+///
+/// Bitwise XOR, in place (bitmap = bitmap ^ other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_xor(bitmap_t *const bitmap, const bitmap_t *const other);
+
+///
+/// Bitwise XOR, into a destination (dest = a ^ b)
+///  dest may be a or b
+/// \param dest The bitmap to write to
+/// \param a The first operand
+/// \param b The second operand
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_xor_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b);
+
+///
+/// Bitwise AND with the complement of other, in place (bitmap = bitmap & ~other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_andnot(bitmap_t *const bitmap, const bitmap_t *const other);
+
+///
+/// Bitwise AND with the complement of b, into a destination (dest = a & ~b)
+///  dest may be a or b
+/// \param dest The bitmap to write to
+/// \param a The first operand
+/// \param b The second operand
+/// \return true on success, false on error (NULL, size mismatch)
+///
+bool bitmap_andnot_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b);
+
+///
+/// Checks if two bitmaps hold the same bits
+/// \param a The first bitmap
+/// \param b The second bitmap
+/// \return true if they are the same size and every bit matches, false otherwise/on error
+///
+bool bitmap_equal(const bitmap_t *const a, const bitmap_t *const b);
+
+///
+/// Checks if two bitmaps have any set bit in common
+/// \param a The first bitmap
+/// \param b The second bitmap, must be the same size
+/// \return true if some bit is set in both, false otherwise/on error
+///
+bool bitmap_intersects(const bitmap_t *const a, const bitmap_t *const b);
+
 ///
 /// Find first set
 /// \param bitmap The bitmap
@@ -64,14 +220,114 @@ size_t bitmap_ffs(const bitmap_t *const bitmap);
 ///
 size_t bitmap_ffz(const bitmap_t *const bitmap);
 
+///
+/// Find first set, starting at the given bit
+/// (resume a search with the last result + 1)
+/// \param bitmap The bitmap
+/// \param bit The first bit to consider
+/// \return The first one bit address at or after bit, SIZE_MAX on error/not found
+///
+size_t bitmap_ffs_from(const bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Find first zero, starting at the given bit
+/// (resume a search with the last result + 1)
+/// \param bitmap The bitmap
+/// \param bit The first bit to consider
+/// \return The first zero bit address at or after bit, SIZE_MAX on error/not found
+///
+size_t bitmap_ffz_from(const bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Find last set
+/// \param bitmap The bitmap
+/// \return The last one bit address, SIZE_MAX on error/not found
+///
+size_t bitmap_fls(const bitmap_t *const bitmap);
+
+///
+/// Find last zero
+/// \param bitmap The bitmap
+/// \return The last zero bit address, SIZE_MAX on error/not found
+///
+size_t bitmap_flz(const bitmap_t *const bitmap);
+
+///
+/// Find last set, before the given bit
+/// (resume a search with the last result)
+/// \param bitmap The bitmap
+/// \param bit The search stops before this bit (values past the end search the whole bitmap)
+/// \return The last one bit address before bit, SIZE_MAX on error/not found
+///
+size_t bitmap_fls_before(const bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Find last zero, before the given bit
+/// (resume a search with the last result)
+/// \param bitmap The bitmap
+/// \param bit The search stops before this bit (values past the end search the whole bitmap)
+/// \return The last zero bit address before bit, SIZE_MAX on error/not found
+///
+size_t bitmap_flz_before(const bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Find the first run of at least n_bits clear bits, starting the search at hint
+/// (does not wrap around, search again from 0 if you need it to)
+/// Big searches are split across threads, see bitmap_set_threads
+/// \param bitmap The bitmap
+/// \param n_bits The length of the run needed
+/// \param hint The first bit to consider
+/// \return The first bit of the run, SIZE_MAX on error/not found
+///
+size_t bitmap_find_zero_run(const bitmap_t *const bitmap, const size_t n_bits, const size_t hint);
+
+///
+/// Find the longest run of clear bits
+/// Big bitmaps are split across threads, see bitmap_set_threads
+/// \param bitmap The bitmap
+/// \param run_start Optional destination for the first bit of the run (SIZE_MAX if there is no run)
+/// \return The length of the longest run, 0 on error/not found
+///
+size_t bitmap_longest_zero_run(const bitmap_t *const bitmap, size_t *const run_start);
+
+///
+/// Atomically sets a bit and reports what it was
+/// Note: The atomic functions are safe to call from several threads at once on the same bitmap,
+///  but only against each other. Everything else still needs the caller to hold a lock.
+///  The summary (see bitmap_summarize), rank index (see bitmap_build_rank_index), and count
+///  (see bitmap_track_count) are all kept up, so the two kinds of calls can be mixed once things are quiet.
+/// \param bitmap The bitmap
+/// \param bit The bit to set
+/// \return The previous value of the bit, false on error
+///
+bool bitmap_test_and_set(bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Atomically resets a bit and reports what it was
+/// \param bitmap The bitmap
+/// \param bit The bit to reset
+/// \return The previous value of the bit, false on error
+///
+bool bitmap_test_and_reset(bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Atomically finds a clear bit and sets it, searching from hint and wrapping around once
+///  If another thread gets there first, the search just moves on to the next clear bit
+/// \param bitmap The bitmap
+/// \param hint Where to start looking (anything past the end means the start)
+/// \return The bit that was claimed, SIZE_MAX on error/full
+///
+size_t bitmap_ffz_and_claim(bitmap_t *const bitmap, const size_t hint);
+
 ///
 /// Count all bits set
+///  (O(1) in counting mode, see bitmap_track_count, big bitmaps are split across threads otherwise)
 /// \param bitmap the bitmap
 /// \return the total number of bits that are set in the bitmap
 ///
 size_t bitmap_total_set(const bitmap_t *const bitmap);
 ///
-/// For each loop for all set bits
+/// For each loop for all set bits, in order (on the calling thread, see bitmap_for_each_unordered)
 ///  (Arguments passed to func are saved across calls)
 /// \param bitmap The bitmap
 /// \param func The function to apply (first parameter will be size_t with the bit number)
@@ -79,6 +335,48 @@ size_t bitmap_total_set(const bitmap_t *const bitmap);
 ///
 void bitmap_for_each(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args);
 
+///
+/// For each loop for all set bits, in no particular order
+///  Big bitmaps are split across threads, and func gets called from all of them at once
+///  (the calling thread included), so func and whatever args points to have to be thread safe.
+///  Every set bit is still visited exactly once. Small bitmaps just get for_each.
+/// \param bitmap The bitmap
+/// \param func The function to apply (first parameter will be size_t with the bit number)
+/// \param args A generic pointer to pass to the called function
+///
+void bitmap_for_each_unordered(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args);
+
+///
+/// Sets how many threads the big scans (total_set, for_each_unordered, find_zero_run, longest_zero_run)
+///  can use. Only bitmaps of 4MB or more get split up, for_each always stays in order on the calling thread.
+///  Set it before you start scanning, it applies to every bitmap.
+/// \param threads The number of threads (capped at 64), 0 for one per CPU (the default), 1 for none
+///
+void bitmap_set_threads(const size_t threads);
+
+///
+/// Copies out the addresses of set bits, in order, starting from a cursor
+///  The cursor is moved past what was copied out, so calling again picks up where it left off
+///  (start the cursor at 0, it ends up at the bit count when there is nothing left)
+/// \param bitmap The bitmap
+/// \param out_indices Where to put the bit addresses
+/// \param max Room in out_indices
+/// \param cursor The bit to start from, updated for the next call
+/// \return The number of addresses written, 0 on error/nothing left
+///
+size_t bitmap_extract_set(const bitmap_t *const bitmap, size_t *const out_indices, const size_t max, size_t *const cursor);
+
+///
+/// Finds the next run of set bits, for walking the bitmap a run at a time
+///  Start pos at 0 and call until it returns false, pos is left just past the run it found
+/// \param bitmap The bitmap
+/// \param pos The bit to start searching from, updated for the next call
+/// \param start Where to put the first bit of the run
+/// \param length Where to put the length of the run
+/// \return true if a run was found, false on error/nothing left
+///
+bool bitmap_next_run(const bitmap_t *const bitmap, size_t *const pos, size_t *const start, size_t *const length);
+
 ///
 /// Resets bitmap contents to the desired pattern
 /// (pattern not guarenteed accurate for final bits
@@ -137,6 +435,75 @@ bitmap_t *bitmap_import(const size_t n_bits, const void *const bitmap_data);
 ///
 bitmap_t *bitmap_overlay(const size_t n_bits, void *const bitmap_data);
 
+///
+/// Creates a bitmap backed by a file, mapped into memory
+/// Note: Writes go straight to the mapping, so the file is only written where pages got dirty
+///  The file is created if it doesn't exist and grown (with zeros) if it's too small, it's never shrunk
+///  Treat it like an overlay for the summary/rank/counting modes, it starts out with whatever the file has
+///  Destroying it syncs and unmaps it
+/// \param path The file to map
+/// \param n_bits The number of bits in the bitmap
+/// \param flags BITMAP_MAP_DEFAULT, or BITMAP_MAP_POPULATE to fault it all in now
+/// \return New bitmap pointer, NULL on error
+///
+bitmap_t *bitmap_map_file(const char *const path, const size_t n_bits, const BITMAP_MAP_FLAGS flags);
+
+///
+/// Writes a file mapped bitmap's dirty pages back to the file (msync)
+/// \param bitmap The bitmap
+/// \param wait true to block until it's on disk, false to just get it started
+/// \return true on success (and for bitmaps that aren't mapped, which have nothing to write), false on error
+///
+bool bitmap_sync(bitmap_t *const bitmap, const bool wait);
+
+///
+/// Builds (or rebuilds) a summary level over the bitmap: one bit per 64-bit word
+///  that says whether the word has any bits set and whether it has any clear
+/// The summary is kept up to date by every bitmap function that writes,
+///  so ffs/ffz (and everything built on them) skip 4096 bits at a time instead of 64
+/// Note: Writes to overlaid memory that don't go through the bitmap aren't seen,
+///  call this again after doing that
+/// \param bitmap The bitmap
+/// \return true on success, false on error (the bitmap is left as it was)
+///
+bool bitmap_summarize(bitmap_t *const bitmap);
+
+///
+/// Turns on counting mode: the number of set bits is kept up to date by every write,
+///  so bitmap_total_set is O(1) from here on
+/// Calling it counts the bits once, so call it again to resync after writing to overlaid memory
+///  behind the bitmap's back (and right after creating an overlay, if you want it counted)
+/// \param bitmap The bitmap
+/// \return true on success, false on error
+///
+bool bitmap_track_count(bitmap_t *const bitmap);
+
+///
+/// Builds (or rebuilds) a rank/select index: a running count of set bits every 512 bits
+///  Writes only mark the index stale from where they happened, the next rank/select call catches it up
+///  Without the index, rank and select still work, they just scan
+/// Note: Like the summary, writes to overlaid memory behind the bitmap's back aren't seen
+/// \param bitmap The bitmap
+/// \return true on success, false on error (the bitmap is left as it was)
+///
+bool bitmap_build_rank_index(bitmap_t *const bitmap);
+
+///
+/// Counts the set bits before a position
+/// \param bitmap The bitmap
+/// \param bit The position (anything past the end counts the whole bitmap)
+/// \return The number of set bits in [0, bit), 0 on error
+///
+size_t bitmap_rank(const bitmap_t *const bitmap, const size_t bit);
+
+///
+/// Finds the k-th set bit (counting from 0, so select(0) is ffs)
+/// \param bitmap The bitmap
+/// \param k Which set bit to find
+/// \return The address of the k-th set bit, SIZE_MAX on error/not found
+///
+size_t bitmap_select(const bitmap_t *const bitmap, const size_t k);
+
 ///
 /// Destructs and destroys bitmap object
 /// \param bitmap The bitmap
@@ -0,0 +1,145 @@
+#ifndef BITMAP_INLINE_H__
+#define BITMAP_INLINE_H__
+
+#include "bitmap.h"
+
+// Opt-in inline versions of the hot path (test/set/reset/flip and word access)
+// Every call into the shared library is a PLT jump to change one byte, include this instead
+// and the compiler gets to inline (and vectorize) your loops.
+//
+// The price is that the struct layout is out in the open. The library itself is built from this
+// definition, so they always agree, but code compiled against one version's layout has to run
+// with that version's library. bitmap.h users don't see any of this and the exports don't change.
+//
+// Same rules as bitmap.h: no NULL or range checks.
+// Writes that the library has bookkeeping for (summary, rank index, counting mode)
+// go out of line to the real functions, so mixing the two APIs is always safe.
+
+struct bitmap {
+    unsigned leftover_bits; // Packing will increase this to an int anyway
+    unsigned flags; // BITMAP_FLAGS, see bitmap.c. Not enough flags to worry about width yet.
+    uint8_t *data;
+    size_t bit_count, byte_count;
+    // word_count is how many 64-bit words cover bit_count
+    // full_words is how many of those we can load directly (an overlay may end mid-word)
+    size_t word_count, full_words;
+    // Summary level (only with SUMMARY), native uint64_t, bit w is about data word w
+    // has_set: word w has a set bit, has_clear: word w has a clear bit (ignoring the undetermined tail)
+    // summary owns the allocation, invert just swaps the other two
+    uint64_t *summary, *has_set, *has_clear;
+    // Rank/select index (only with RANKED), see rank_index_t
+    struct rank_index *rank;
+    // Bits set (only with COUNTED), what total_set hands back
+    size_t set_count;
+};
+
+// The flags that mean a write has bookkeeping to do (SUMMARY | RANKED | COUNTED)
+#define BITMAP_INLINE_BOOKKEEPING 0x0E
+
+///
+/// Returns bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to query
+/// \return State of requested bit
+///
+static inline bool bitmap_inline_test(const bitmap_t *const bitmap, const size_t bit) {
+    return bitmap->data[bit >> 3] & (1u << (bit & 0x07));
+}
+
+///
+/// Sets requested bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to set
+///
+static inline void bitmap_inline_set(bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap->flags & BITMAP_INLINE_BOOKKEEPING) {
+        bitmap_set(bitmap, bit);
+        return;
+    }
+    bitmap->data[bit >> 3] |= (uint8_t) (1u << (bit & 0x07));
+}
+
+///
+/// Clears requested bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to clear
+///
+static inline void bitmap_inline_reset(bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap->flags & BITMAP_INLINE_BOOKKEEPING) {
+        bitmap_reset(bitmap, bit);
+        return;
+    }
+    bitmap->data[bit >> 3] &= (uint8_t) ~(1u << (bit & 0x07));
+}
+
+///
+/// Flips bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to flip
+///
+static inline void bitmap_inline_flip(bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap->flags & BITMAP_INLINE_BOOKKEEPING) {
+        bitmap_flip(bitmap, bit);
+        return;
+    }
+    bitmap->data[bit >> 3] ^= (uint8_t) (1u << (bit & 0x07));
+}
+
+///
+/// Gets the number of 64-bit words covering the bitmap
+/// \param bitmap The bitmap
+/// \return The number of words
+///
+static inline size_t bitmap_inline_word_count(const bitmap_t *const bitmap) {
+    return bitmap->word_count;
+}
+
+///
+/// Loads a word of the bitmap, bit b of word w is bit (w * 64 + b)
+///  Bits past the end of the bitmap are undetermined
+/// \param bitmap The bitmap
+/// \param word The word to load
+/// \return The word
+///
+static inline uint64_t bitmap_inline_load_word(const bitmap_t *const bitmap, const size_t word) {
+    // The byte layout is a little-endian array of words, memcpy keeps unaligned overlays legal
+    // and compiles down to a single mov. Overlays that end mid-word get built a byte at a time.
+    uint64_t value = 0;
+    if (word < bitmap->full_words) {
+        memcpy(&value, bitmap->data + (word * sizeof(uint64_t)), sizeof(uint64_t));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        value = __builtin_bswap64(value);
+#endif
+        return value;
+    }
+    for (size_t byte = word * sizeof(uint64_t), shift = 0; byte < bitmap->byte_count; ++byte, shift += 8) {
+        value |= ((uint64_t) bitmap->data[byte]) << shift;
+    }
+    return value;
+}
+
+///
+/// Stores a word of the bitmap, bit b of word w is bit (w * 64 + b)
+///  Bits past the end of the bitmap stay undetermined, whatever you store there
+/// \param bitmap The bitmap
+/// \param word The word to store
+/// \param value The new value
+///
+static inline void bitmap_inline_store_word(bitmap_t *const bitmap, const size_t word, uint64_t value) {
+    if (bitmap->flags & BITMAP_INLINE_BOOKKEEPING) {
+        bitmap_store_word(bitmap, word, value);
+        return;
+    }
+    if (word < bitmap->full_words) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        value = __builtin_bswap64(value);
+#endif
+        memcpy(bitmap->data + (word * sizeof(uint64_t)), &value, sizeof(uint64_t));
+        return;
+    }
+    for (size_t byte = word * sizeof(uint64_t); byte < bitmap->byte_count; ++byte, value >>= 8) {
+        bitmap->data[byte] = (uint8_t) value;
+    }
+}
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef CBITMAP_H__
+#define CBITMAP_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Compressed bitmap, for when bitmap_t would be mostly empty (or huge)
+// The bits are split into 64K chunks, and only chunks with something in them take up space
+// Each chunk picks whichever of these is smallest (roaring bitmap style):
+//  array - sorted list of the set bits (up to 4096 of them)
+//  bitset - a plain 8KB bitmap
+//  run - sorted list of (start, length) runs
+// Memory and iteration cost go with how many bits are set instead of how big the bitmap is
+
+typedef struct cbitmap cbitmap_t;
+
+// Unlike bitmap_t, bits outside the bitmap are checked for (and rejected)
+// since setting a bit can allocate, and that can fail anyway.
+
+///
+/// Creates a compressed bitmap to contain n bits (zero initialized)
+/// \param n_bits The number of bits in the bitmap
+/// \return New bitmap pointer, NULL on error
+///
+cbitmap_t *cbitmap_create(const size_t n_bits);
+
+///
+/// Destructs and destroys compressed bitmap object
+/// \param bitmap The bitmap
+///
+void cbitmap_destroy(cbitmap_t *bitmap);
+
+///
+/// Sets requested bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to set
+/// \return true on success, false on error (out of range, memory)
+///
+bool cbitmap_set(cbitmap_t *const bitmap, const size_t bit);
+
+///
+/// Clears requested bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to clear
+/// \return true on success, false on error (out of range, memory)
+///
+bool cbitmap_reset(cbitmap_t *const bitmap, const size_t bit);
+
+///
+/// Returns bit in bitmap
+/// \param bitmap The bitmap
+/// \param bit The bit to query
+/// \return State of requested bit, false on error
+///
+bool cbitmap_test(const cbitmap_t *const bitmap, const size_t bit);
+
+///
+/// Find first set
+/// \param bitmap The bitmap
+/// \return The first one bit address, SIZE_MAX on error/not found
+///
+size_t cbitmap_ffs(const cbitmap_t *const bitmap);
+
+///
+/// Find first zero
+/// \param bitmap The bitmap
+/// \return The first zero bit address, SIZE_MAX on error/not found
+///
+size_t cbitmap_ffz(const cbitmap_t *const bitmap);
+
+///
+/// Count all bits set
+/// \param bitmap The bitmap
+/// \return The number of set bits, 0 on error
+///
+size_t cbitmap_total_set(const cbitmap_t *const bitmap);
+
+///
+/// Gets total number of bits in bitmap
+/// \param bitmap The bitmap
+/// \return The number of bits in the bitmap, 0 on error
+///
+size_t cbitmap_get_bits(const cbitmap_t *const bitmap);
+
+///
+/// For each loop for all set bits, in order
+///  (Arguments passed to func are saved across calls)
+/// \param bitmap The bitmap
+/// \param func The function to apply (first parameter will be size_t with the bit number)
+/// \param args A generic pointer to pass to the called function
+///
+void cbitmap_for_each(const cbitmap_t *const bitmap, void (*func)(size_t, void *), void *args);
+
+///
+/// Bitwise AND, in place (bitmap = bitmap & other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch, memory)
+///  (on a memory error, some chunks may have been combined and others not)
+///
+bool cbitmap_and(cbitmap_t *const bitmap, const cbitmap_t *const other);
+
+///
+/// Bitwise OR, in place (bitmap = bitmap | other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch, memory)
+///  (on a memory error, some chunks may have been combined and others not)
+///
+bool cbitmap_or(cbitmap_t *const bitmap, const cbitmap_t *const other);
+
+///
+/// Bitwise XOR, in place (bitmap = bitmap ^ other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch, memory)
+///  (on a memory error, some chunks may have been combined and others not)
+///
+bool cbitmap_xor(cbitmap_t *const bitmap, const cbitmap_t *const other);
+
+///
+/// Bitwise AND with the complement of other, in place (bitmap = bitmap & ~other)
+/// \param bitmap The bitmap to modify
+/// \param other The other bitmap, must be the same size
+/// \return true on success, false on error (NULL, size mismatch, memory)
+///  (on a memory error, some chunks may have been combined and others not)
+///
+bool cbitmap_andnot(cbitmap_t *const bitmap, const cbitmap_t *const other);
+
+///
+/// Re-picks the smallest container for every chunk, turning long stretches into runs
+///  Set and reset never create runs on their own, so call this once things settle down
+///  (before serializing is a good time)
+/// \param bitmap The bitmap
+/// \return true on success, false on error (the bitmap is still valid)
+///
+bool cbitmap_optimize(cbitmap_t *const bitmap);
+
+///
+/// Gets the number of bytes cbitmap_serialize needs
+/// \param bitmap The bitmap
+/// \return The serialized size in bytes, 0 on error
+///
+size_t cbitmap_serialized_size(const cbitmap_t *const bitmap);
+
+///
+/// Writes the bitmap to a buffer in a portable (little-endian) format
+/// \param bitmap The bitmap
+/// \param buffer The buffer to write to
+/// \param size The size of the buffer
+/// \return The number of bytes written, 0 on error (including the buffer being too small)
+///
+size_t cbitmap_serialize(const cbitmap_t *const bitmap, void *const buffer, const size_t size);
+
+///
+/// Creates a new compressed bitmap from serialized data
+/// \param buffer The serialized data
+/// \param size The size of the data
+/// \return New bitmap pointer, NULL on error (including malformed data)
+///
+cbitmap_t *cbitmap_deserialize(const void *const buffer, const size_t size);
+
+#endif
@@ -1,15 +1,44 @@
+// mmap/msync/ftruncate and MAP_POPULATE are hidden by plain -std=c99
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE
+#endif
 #include "../include/bitmap.h"
+#include "../include/bitmap_inline.h"
 
-// Just the one for now. Indicates we're an overlay and should not free
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// OVERLAY indicates we're an overlay and should not free
+// SUMMARY indicates the summary level exists and has to be maintained
+// RANKED indicates the rank/select index exists and has to be told about changes
+// COUNTED indicates set_count is live and every write has to keep it exact
+// MAPPED goes with OVERLAY, data is a file mapping we have to unmap (not free)
 // (also, make sure that ALL is as wide as ll of the flags)
-typedef enum {NONE = 0x00, OVERLAY = 0x01, ALL = 0xFF} BITMAP_FLAGS;
+typedef enum {NONE = 0x00, OVERLAY = 0x01, SUMMARY = 0x02, RANKED = 0x04, COUNTED = 0x08, MAPPED = 0x10, ALL = 0xFF} BITMAP_FLAGS;
+// Anything that writes has to check for these
+#define AUX_FLAGS (SUMMARY | RANKED)
+
+// What to do with a pair of words in the two-bitmap functions (and/or/xor/andnot/equal/intersects)
+typedef enum {OP_AND, OP_OR, OP_XOR, OP_ANDNOT} BITMAP_OP;
 
-struct bitmap {
-    unsigned leftover_bits; // Packing will increase this to an int anyway
-    BITMAP_FLAGS flags; // Generic place to store flags. Not enough flags to worry about width yet.
-    uint8_t *data;
-    size_t bit_count, byte_count;
-};
+// struct bitmap lives in bitmap_inline.h so the inline API can't disagree with us about the layout
+_Static_assert(BITMAP_INLINE_BOOKKEEPING == (AUX_FLAGS | COUNTED), "bitmap_inline.h has the wrong bookkeeping flags");
+
+// Rank/select index
+// counts[s] is the number of bits set before superblock s (8 words, so one cache line of data)
+// with counts[superblocks] being the total. Writes just note the lowest superblock they touched,
+// and the counts from there on get redone the next time somebody asks.
+// It's separately allocated so the const query functions can bring it up to date.
+#define RANK_SUPERBLOCK_SHIFT 3
+#define RANK_SUPERBLOCK_WORDS (1 << RANK_SUPERBLOCK_SHIFT)
+typedef struct rank_index {
+    size_t stale_from; // first superblock whose count can't be trusted, SIZE_MAX when they all can
+    size_t superblocks;
+    size_t counts[];
+} rank_index_t;
 
 
 #define FLAG_CHECK(bitmap, flag) (bitmap->flags & flag)
@@ -22,9 +51,6 @@ struct bitmap {
 //  Won't help until bitmap uses native width for the array
 const static uint8_t mask[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
 
-// Mask for all bits at index i and lower
-const static uint8_t mask_down_inclusive[8] = {0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF};
-
 // Inverted mask
 const static uint8_t invert_mask[8] = { 0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F};
 
@@ -33,37 +59,512 @@ const static uint8_t invert_mask[8] = { 0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF
 // Since the data store is uint8_t, we already get punished for our bad alignment
 // so this doesn't really matter until everything gets moved to generic int
 
-// Total bits set in the given byte in a handy lookup table
-// Macros, man...
-// http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetTable
-#define B2(n) n,     n+1,     n+1,     n+2
-#define B4(n) B2(n), B2(n+1), B2(n+1), B2(n+2)
-#define B6(n) B4(n), B4(n+1), B4(n+1), B4(n+2)
-const static uint8_t bit_totals[256] = { B6(0), B6(1), B6(1), B6(2) };
-#undef B6
-#undef B4
-#undef B2
-// There is an alternative for getting bit count that only loops as many times as there are bits set
-// but that's still a loop and this table is 256B.
-/*
-    unsigned int v; // count the number of bits set in v
-    unsigned int c; // c accumulates the total bits set in v
-
-    for (c = 0; v; v >>= 1)
-    {
-      c += v & 1;
-    }
-*/
+// Bit counting used to be a 256 entry lookup table per byte
+// Now it's popcount on whole words, see the kernels below
+
+// Native word handling
+// The byte layout (bit n is bit (n & 7) of byte (n >> 3)) is what export/overlay promise
+// so it can't change. Luckily, that's exactly a little-endian array of uint64_t,
+// so we load words out of the byte array and only have to swap on big-endian machines.
+// memcpy keeps us legal for unaligned overlays, compilers turn it into a single mov.
+#define WORD_SHIFT 6
+#define WORD_MASK 0x3F
+#define WORD_BYTES sizeof(uint64_t)
+#define WORD_COUNT(n_bits) (((n_bits) + WORD_MASK) >> WORD_SHIFT)
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define WORD_FROM_LE(word) __builtin_bswap64(word)
+#else
+    #define WORD_FROM_LE(word) (word)
+#endif
+#define WORD_TO_LE(word) WORD_FROM_LE(word)
+
+// Index of the lowest/highest set bit in a word, word MUST be non-zero
+// (they compile down to tzcnt/bsf and lzcnt/bsr)
+#define WORD_CTZ(word) ((size_t) __builtin_ctzll(word))
+#define WORD_CLZ(word) ((size_t) __builtin_clzll(word))
+
+static inline uint64_t word_load(const bitmap_t *const bitmap, const size_t word) {
+    return bitmap_inline_load_word(bitmap, word);
+}
+
+// Skips the bookkeeping (summary, rank index, count), so it stays in here, the callers keep those up to date
+static inline void word_store(bitmap_t *const bitmap, const size_t word, uint64_t value) {
+    if (word < bitmap->full_words) {
+        value = WORD_TO_LE(value);
+        memcpy(bitmap->data + (word * WORD_BYTES), &value, WORD_BYTES);
+        return;
+    }
+    for (size_t byte = word * WORD_BYTES; byte < bitmap->byte_count; ++byte, value >>= 8) {
+        bitmap->data[byte] = (uint8_t) value;
+    }
+}
+
+// Mask of the bits in the final word that are actually part of the bitmap
+// Everything past bit_count is undetermined and has to be masked off before we look at it
+static inline uint64_t word_tail_mask(const bitmap_t *const bitmap) {
+    return (bitmap->bit_count & WORD_MASK) ? ((((uint64_t) 1) << (bitmap->bit_count & WORD_MASK)) - 1) : ~((uint64_t) 0);
+}
+
+// Loads a word (optionally inverted, pass ~0 to look for zeroes) with the bits past the end cleared
+static inline uint64_t word_load_masked(const bitmap_t *const bitmap, const size_t word, const uint64_t invert) {
+    const uint64_t value = word_load(bitmap, word) ^ invert;
+    return (word == bitmap->word_count - 1) ? (value & word_tail_mask(bitmap)) : value;
+}
+
+// Mask of the bits in [start, end) that land in the given word (start < end, both in range)
+static inline uint64_t word_range_mask(const size_t word, const size_t start, const size_t end) {
+    uint64_t mask = ~((uint64_t) 0);
+    if (word == (start >> WORD_SHIFT)) {
+        mask &= ~((uint64_t) 0) << (start & WORD_MASK);
+    }
+    if (word == ((end - 1) >> WORD_SHIFT)) {
+        mask &= ~((uint64_t) 0) >> (WORD_MASK - ((end - 1) & WORD_MASK));
+    }
+    return mask;
+}
+
+// The atomic functions work on whole words where they can
+// That needs the word fully backed and 8-byte aligned (ours always are, overlays might not be)
+// Anything else falls back to byte atomics. A given word always gets the same treatment
+static inline uint64_t *atomic_word(const bitmap_t *const bitmap, const size_t word) {
+    uint8_t *const position = bitmap->data + (word * WORD_BYTES);
+    return (word < bitmap->full_words && !((uintptr_t) position & (WORD_BYTES - 1))) ? (uint64_t *) position : NULL;
+}
+
+// word_load_masked for the atomic functions, other threads can be writing the word while we read it
+// A word atomic_word won't hand out gets loaded a byte at a time (each byte is atomic, the whole isn't)
+// That can be a whole misaligned word, so it stops after 8 bytes, not just at the end of the data
+static inline uint64_t atomic_word_load_masked(const bitmap_t *const bitmap, const size_t word) {
+    const uint64_t *const position = atomic_word(bitmap, word);
+    uint64_t value = 0;
+    if (position) {
+        value = WORD_FROM_LE(__atomic_load_n(position, __ATOMIC_ACQUIRE));
+    } else {
+        const size_t end = (word + 1) * WORD_BYTES < bitmap->byte_count ? (word + 1) * WORD_BYTES : bitmap->byte_count;
+        for (size_t byte = word * WORD_BYTES, shift = 0; byte < end; ++byte, shift += 8) {
+            value |= ((uint64_t) __atomic_load_n(bitmap->data + byte, __ATOMIC_ACQUIRE)) << shift;
+        }
+    }
+    return (word == bitmap->word_count - 1) ? (value & word_tail_mask(bitmap)) : value;
+}
+
+// One word of a BITMAP_OP (bitwise, so it doesn't care about byte order)
+static inline uint64_t word_combine(const uint64_t a, const uint64_t b, const BITMAP_OP op) {
+    switch (op) {
+        case OP_AND:
+            return a & b;
+        case OP_OR:
+            return a | b;
+        case OP_XOR:
+            return a ^ b;
+        default:
+            return a & ~b;
+    }
+}
+
+// Summary level helpers
+
+// Brings word's summary bits in line with the data
+static inline void summary_update(bitmap_t *const bitmap, const size_t word) {
+    const uint64_t bit = ((uint64_t) 1) << (word & WORD_MASK);
+    if (word_load_masked(bitmap, word, 0)) {
+        bitmap->has_set[word >> WORD_SHIFT] |= bit;
+    } else {
+        bitmap->has_set[word >> WORD_SHIFT] &= ~bit;
+    }
+    if (word_load_masked(bitmap, word, ~((uint64_t) 0))) {
+        bitmap->has_clear[word >> WORD_SHIFT] |= bit;
+    } else {
+        bitmap->has_clear[word >> WORD_SHIFT] &= ~bit;
+    }
+}
+
+// First data word in [word, last] flagged in the summary, SIZE_MAX if none
+// The loads are relaxed atomics (plain movs on anything we care about) since the atomic
+// functions use this too, while other threads are updating the summary
+static inline size_t summary_next(const uint64_t *const summary, const size_t word, const size_t last) {
+    if (word > last) {
+        return SIZE_MAX;
+    }
+    size_t index = word >> WORD_SHIFT;
+    uint64_t value = __atomic_load_n(summary + index, __ATOMIC_RELAXED) & (~((uint64_t) 0) << (word & WORD_MASK));
+    while (!value) {
+        if (++index > (last >> WORD_SHIFT)) {
+            return SIZE_MAX;
+        }
+        value = __atomic_load_n(summary + index, __ATOMIC_RELAXED);
+    }
+    const size_t result = (index << WORD_SHIFT) + WORD_CTZ(value);
+    return result <= last ? result : SIZE_MAX;
+}
+
+// Sets or clears every bit in [start, end), the core of set_range/reset_range
+void bitmap_fill_range(bitmap_t *const bitmap, const size_t start, const size_t end, const bool value);
+
+// Claims (atomically sets) the first clear bit in [bit, end), SIZE_MAX if there wasn't one
+size_t bitmap_claim_forward(bitmap_t *const bitmap, size_t bit, const size_t end);
+
+// Core of the two-bitmap functions. dest = a op b, false if anything is NULL or the sizes differ
+bool bitmap_combine(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b, const BITMAP_OP op);
+
+// Core of equal/intersects. Is (a op b) non-zero anywhere? (a and b are already known to be the same size)
+bool bitmap_combine_any(const bitmap_t *const a, const bitmap_t *const b, const BITMAP_OP op);
+
+// Tells the summary/rank index that words [first, last] changed (only call with AUX_FLAGS set)
+void bitmap_touch(bitmap_t *const bitmap, const size_t first, const size_t last);
+
+// bitmap_touch for the atomic functions, safe against other threads doing the same to the same word
+void bitmap_atomic_touch(bitmap_t *const bitmap, const size_t word);
+
+// Counts the bits set the long way (what total_set does without COUNTED)
+size_t bitmap_popcount(const bitmap_t *const bitmap);
+
+// Threads for the big scans
+// Anything covering at least BITMAP_PARALLEL_MIN_WORDS (4MB) gets cut into chunks that
+// worker threads (and the caller) grab until they run out. Below that, it's not worth the threads.
+// Chunk results are kept on the stack, hence the cap on threads.
+#ifndef BITMAP_PARALLEL_MIN_WORDS
+    #define BITMAP_PARALLEL_MIN_WORDS (((size_t) 1) << 19)
+#endif
+#define BITMAP_MAX_THREADS 64
+#define BITMAP_CHUNKS_PER_THREAD 4
+#define BITMAP_MAX_CHUNKS (BITMAP_MAX_THREADS * BITMAP_CHUNKS_PER_THREAD)
+
+// How many chunks to cut n_words into, 0 if it should just be done on this thread
+size_t bitmap_parallel_chunks(const size_t n_words);
+
+// Runs job(ctx, chunk) for every chunk in [0, chunks), spread over the threads
+void bitmap_parallel(const size_t chunks, void (*job)(void *const, const size_t), void *const ctx);
+
+// Multi-threaded versions of for_each_unordered and find_zero_run/longest_zero_run (n_bits == 0 for longest)
+// Only call them with something from bitmap_parallel_chunks
+void bitmap_for_each_parallel(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args, const size_t chunks);
+size_t bitmap_zero_run_parallel(const bitmap_t *const bitmap, const size_t n_bits, const size_t hint, size_t *const run_start,
+                                const size_t chunks);
+
+// Brings the rank index up to date if writes got to it
+void bitmap_rank_refresh(const bitmap_t *const bitmap);
+
+// Recomputes the summary for words [first, last]
+void bitmap_summary_rebuild(bitmap_t *const bitmap, const size_t first, const size_t last);
+
+// Search cores for the ffX/flX families. invert is 0 to look for ones, ~0 to look for zeroes
+// (forward searches stop before end)
+size_t bitmap_scan_forward(const bitmap_t *const bitmap, const size_t bit, const size_t end, const uint64_t invert);
+
+size_t bitmap_scan_backward(const bitmap_t *const bitmap, const size_t bit, const uint64_t invert);
 
 // A place to generalize the creation process and setup
 bitmap_t *bitmap_initialize(size_t n_bits, BITMAP_FLAGS flags);
 
+// Bulk kernels
+// These do the heavy lifting over runs of whole words (so data must hold n_words full words)
+// We pick the best set the CPU supports once, at load time, and everything else goes through the table
+// The sets are scalar, SSE4.2 (2 words at a time, hardware popcnt), and AVX2 (4 words at a time)
+// A CPU with popcnt but not the rest of SSE4.2 just gets the popcnt popcount
+//  popcount - total bits set
+//  invert - flip every bit
+//  scan - index of the first word that isn't all zero (after xor with invert), n_words if none
+//  combine - dest = a op b (dest may be a or b)
+//  compare - index of the first word where a op b isn't zero, n_words if none
+// format is just memset, libc already picks a vector-width memset for us
+typedef struct {
+    size_t (*popcount)(const uint8_t *const data, const size_t n_words);
+    void (*invert)(uint8_t *const data, const size_t n_words);
+    size_t (*scan)(const uint8_t *const data, const size_t n_words, const uint64_t invert);
+    void (*combine)(uint8_t *const dest, const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op);
+    size_t (*compare)(const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op);
+} bitmap_kernels_t;
+
+// Portable versions, these are what you get if we can't tell what the CPU is
+// (__builtin_popcountll is a few shifts and adds without hardware popcount)
+static size_t scalar_popcount(const uint8_t *const data, const size_t n_words) {
+    size_t total = 0;
+    uint64_t value;
+    for (size_t word = 0; word < n_words; ++word) {
+        memcpy(&value, data + (word * WORD_BYTES), WORD_BYTES);
+        total += __builtin_popcountll(value);
+    }
+    return total;
+}
+
+static void scalar_invert(uint8_t *const data, const size_t n_words) {
+    uint64_t value;
+    for (size_t word = 0; word < n_words; ++word) {
+        memcpy(&value, data + (word * WORD_BYTES), WORD_BYTES);
+        value = ~value;
+        memcpy(data + (word * WORD_BYTES), &value, WORD_BYTES);
+    }
+}
+
+static size_t scalar_scan(const uint8_t *const data, const size_t n_words, const uint64_t invert) {
+    // Byte order doesn't matter when all we want to know is zero or not zero
+    uint64_t value;
+    size_t word = 0;
+    for (; word < n_words; ++word) {
+        memcpy(&value, data + (word * WORD_BYTES), WORD_BYTES);
+        if (value ^ invert) {
+            break;
+        }
+    }
+    return word;
+}
+
+static void scalar_combine(uint8_t *const dest, const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    uint64_t value_a, value_b;
+    for (size_t word = 0; word < n_words; ++word) {
+        memcpy(&value_a, a + (word * WORD_BYTES), WORD_BYTES);
+        memcpy(&value_b, b + (word * WORD_BYTES), WORD_BYTES);
+        value_a = word_combine(value_a, value_b, op);
+        memcpy(dest + (word * WORD_BYTES), &value_a, WORD_BYTES);
+    }
+}
+
+static size_t scalar_compare(const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    uint64_t value_a, value_b;
+    size_t word = 0;
+    for (; word < n_words; ++word) {
+        memcpy(&value_a, a + (word * WORD_BYTES), WORD_BYTES);
+        memcpy(&value_b, b + (word * WORD_BYTES), WORD_BYTES);
+        if (word_combine(value_a, value_b, op)) {
+            break;
+        }
+    }
+    return word;
+}
+
+static bitmap_kernels_t kernels = {&scalar_popcount, &scalar_invert, &scalar_scan, &scalar_combine, &scalar_compare};
+
+// Threads the big scans can use, see bitmap_set_threads
+static size_t bitmap_threads = 0;
+// What 0 (one per CPU) means, looked up once when the library loads (sysconf is a syscall)
+static size_t bitmap_cpus = 1;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BITMAP_X86_KERNELS
+    #include <immintrin.h>
+
+// Same loop as scalar, but the compiler is allowed to use the popcnt instruction (SSE4.2 era)
+__attribute__((target("popcnt")))
+static size_t popcnt_popcount(const uint8_t *const data, const size_t n_words) {
+    size_t total = 0;
+    uint64_t value;
+    for (size_t word = 0; word < n_words; ++word) {
+        memcpy(&value, data + (word * WORD_BYTES), WORD_BYTES);
+        total += __builtin_popcountll(value);
+    }
+    return total;
+}
+
+// SSE4.2 does 2 words at a time. Popcount stays popcnt_popcount, a pshufb popcount
+// on 16 bytes is no faster than two popcnts. The scans need ptest, which is SSE4.1.
+__attribute__((target("sse4.2")))
+static void sse42_invert(uint8_t *const data, const size_t n_words) {
+    const __m128i ones = _mm_set1_epi8((char) 0xFF);
+    size_t word = 0;
+    for (; word + 2 <= n_words; word += 2) {
+        __m128i *const position = (__m128i *)(data + (word * WORD_BYTES));
+        _mm_storeu_si128(position, _mm_xor_si128(_mm_loadu_si128(position), ones));
+    }
+    scalar_invert(data + (word * WORD_BYTES), n_words - word);
+}
+
+__attribute__((target("sse4.2")))
+static size_t sse42_scan(const uint8_t *const data, const size_t n_words, const uint64_t invert) {
+    // Same as avx2_scan, xor with the pattern and ptest for all zero
+    const __m128i pattern = _mm_set1_epi64x((long long) invert);
+    size_t word = 0;
+    for (; word + 2 <= n_words; word += 2) {
+        const __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(data + (word * WORD_BYTES))), pattern);
+        if (!_mm_testz_si128(value, value)) {
+            break;
+        }
+    }
+    return word + scalar_scan(data + (word * WORD_BYTES), n_words - word, invert);
+}
+
+__attribute__((target("sse4.2")))
+static inline __m128i sse42_combine_vector(const __m128i a, const __m128i b, const BITMAP_OP op) {
+    switch (op) {
+        case OP_AND:
+            return _mm_and_si128(a, b);
+        case OP_OR:
+            return _mm_or_si128(a, b);
+        case OP_XOR:
+            return _mm_xor_si128(a, b);
+        default:
+            // pandn complements its FIRST operand
+            return _mm_andnot_si128(b, a);
+    }
+}
+
+__attribute__((target("sse4.2")))
+static void sse42_combine(uint8_t *const dest, const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    size_t word = 0;
+    for (; word + 2 <= n_words; word += 2) {
+        const size_t offset = word * WORD_BYTES;
+        const __m128i value = sse42_combine_vector(_mm_loadu_si128((const __m128i *)(a + offset)),
+                                                   _mm_loadu_si128((const __m128i *)(b + offset)), op);
+        _mm_storeu_si128((__m128i *)(dest + offset), value);
+    }
+    const size_t offset = word * WORD_BYTES;
+    scalar_combine(dest + offset, a + offset, b + offset, n_words - word, op);
+}
+
+__attribute__((target("sse4.2")))
+static size_t sse42_compare(const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    size_t word = 0;
+    for (; word + 2 <= n_words; word += 2) {
+        const size_t offset = word * WORD_BYTES;
+        const __m128i value = sse42_combine_vector(_mm_loadu_si128((const __m128i *)(a + offset)),
+                                                   _mm_loadu_si128((const __m128i *)(b + offset)), op);
+        if (!_mm_testz_si128(value, value)) {
+            break;
+        }
+    }
+    const size_t offset = word * WORD_BYTES;
+    return word + scalar_compare(a + offset, b + offset, n_words - word, op);
+}
+
+// AVX2 does 4 words at a time. Popcount is the nibble lookup (vpshufb) trick summed with vpsadbw
+// http://0x80.pl/articles/sse-popcount.html
+__attribute__((target("avx2,popcnt")))
+static size_t avx2_popcount(const uint8_t *const data, const size_t n_words) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+    __m256i totals = _mm256_setzero_si256();
+    size_t word = 0;
+    for (; word + 4 <= n_words; word += 4) {
+        const __m256i value = _mm256_loadu_si256((const __m256i *)(data + (word * WORD_BYTES)));
+        const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, low_nibbles));
+        const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), low_nibbles));
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    size_t total = _mm256_extract_epi64(totals, 0) + _mm256_extract_epi64(totals, 1)
+                   + _mm256_extract_epi64(totals, 2) + _mm256_extract_epi64(totals, 3);
+    uint64_t value;
+    for (; word < n_words; ++word) {
+        memcpy(&value, data + (word * WORD_BYTES), WORD_BYTES);
+        total += __builtin_popcountll(value);
+    }
+    return total;
+}
+
+__attribute__((target("avx2")))
+static void avx2_invert(uint8_t *const data, const size_t n_words) {
+    const __m256i ones = _mm256_set1_epi8((char) 0xFF);
+    size_t word = 0;
+    for (; word + 4 <= n_words; word += 4) {
+        __m256i *const position = (__m256i *)(data + (word * WORD_BYTES));
+        _mm256_storeu_si256(position, _mm256_xor_si256(_mm256_loadu_si256(position), ones));
+    }
+    scalar_invert(data + (word * WORD_BYTES), n_words - word);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_scan(const uint8_t *const data, const size_t n_words, const uint64_t invert) {
+    // xor with the pattern and vptest for all zero, then narrow it down in the scalar loop
+    const __m256i pattern = _mm256_set1_epi64x((long long) invert);
+    size_t word = 0;
+    for (; word + 4 <= n_words; word += 4) {
+        const __m256i value = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(data + (word * WORD_BYTES))), pattern);
+        if (!_mm256_testz_si256(value, value)) {
+            break;
+        }
+    }
+    return word + scalar_scan(data + (word * WORD_BYTES), n_words - word, invert);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_combine_vector(const __m256i a, const __m256i b, const BITMAP_OP op) {
+    switch (op) {
+        case OP_AND:
+            return _mm256_and_si256(a, b);
+        case OP_OR:
+            return _mm256_or_si256(a, b);
+        case OP_XOR:
+            return _mm256_xor_si256(a, b);
+        default:
+            // vpandn complements its FIRST operand
+            return _mm256_andnot_si256(b, a);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_combine(uint8_t *const dest, const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    size_t word = 0;
+    for (; word + 4 <= n_words; word += 4) {
+        const size_t offset = word * WORD_BYTES;
+        const __m256i value = avx2_combine_vector(_mm256_loadu_si256((const __m256i *)(a + offset)),
+                                                  _mm256_loadu_si256((const __m256i *)(b + offset)), op);
+        _mm256_storeu_si256((__m256i *)(dest + offset), value);
+    }
+    const size_t offset = word * WORD_BYTES;
+    scalar_combine(dest + offset, a + offset, b + offset, n_words - word, op);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_compare(const uint8_t *const a, const uint8_t *const b, const size_t n_words, const BITMAP_OP op) {
+    size_t word = 0;
+    for (; word + 4 <= n_words; word += 4) {
+        const size_t offset = word * WORD_BYTES;
+        const __m256i value = avx2_combine_vector(_mm256_loadu_si256((const __m256i *)(a + offset)),
+                                                  _mm256_loadu_si256((const __m256i *)(b + offset)), op);
+        if (!_mm256_testz_si256(value, value)) {
+            break;
+        }
+    }
+    const size_t offset = word * WORD_BYTES;
+    return word + scalar_compare(a + offset, b + offset, n_words - word, op);
+}
+#endif
+
+// Runs when the library is loaded, picks the kernels and counts the CPUs
+__attribute__((constructor))
+static void bitmap_select_kernels(void) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    bitmap_cpus = cpus > 0 ? (size_t) cpus : 1;
+#ifdef BITMAP_X86_KERNELS
+    // cpuid, via the compiler
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        kernels.popcount = &avx2_popcount;
+        kernels.invert = &avx2_invert;
+        kernels.scan = &avx2_scan;
+        kernels.combine = &avx2_combine;
+        kernels.compare = &avx2_compare;
+    } else if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        kernels.popcount = &popcnt_popcount;
+        kernels.invert = &sse42_invert;
+        kernels.scan = &sse42_scan;
+        kernels.combine = &sse42_combine;
+        kernels.compare = &sse42_compare;
+    } else if (__builtin_cpu_supports("popcnt")) {
+        kernels.popcount = &popcnt_popcount;
+    }
+#endif
+}
+
 void bitmap_set(bitmap_t *const bitmap, const size_t bit) {
+    if (FLAG_CHECK(bitmap, COUNTED) && !bitmap_test(bitmap, bit)) {
+        ++bitmap->set_count;
+    }
     bitmap->data[bit >> 3] |= mask[bit & 0x07];
+    if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+        bitmap_touch(bitmap, bit >> WORD_SHIFT, bit >> WORD_SHIFT);
+    }
 }
 
 void bitmap_reset(bitmap_t *const bitmap, const size_t bit) {
+    if (FLAG_CHECK(bitmap, COUNTED) && bitmap_test(bitmap, bit)) {
+        --bitmap->set_count;
+    }
     bitmap->data[bit >> 3] &= invert_mask[bit & 0x07];
+    if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+        bitmap_touch(bitmap, bit >> WORD_SHIFT, bit >> WORD_SHIFT);
+    }
 }
 
 bool bitmap_test(const bitmap_t *const bitmap, const size_t bit) {
@@ -71,64 +572,364 @@ bool bitmap_test(const bitmap_t *const bitmap, const size_t bit) {
 }
 
 void bitmap_flip(bitmap_t *const bitmap, const size_t bit) {
+    if (FLAG_CHECK(bitmap, COUNTED)) {
+        bitmap->set_count = bitmap_test(bitmap, bit) ? bitmap->set_count - 1 : bitmap->set_count + 1;
+    }
     bitmap->data[bit >> 3] ^= mask[bit & 0x07];
+    if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+        bitmap_touch(bitmap, bit >> WORD_SHIFT, bit >> WORD_SHIFT);
+    }
+}
+
+uint64_t bitmap_load_word(const bitmap_t *const bitmap, const size_t word) {
+    if (bitmap && word < bitmap->word_count) {
+        return word_load(bitmap, word);
+    }
+    return 0;
+}
+
+void bitmap_store_word(bitmap_t *const bitmap, const size_t word, const uint64_t value) {
+    if (bitmap && word < bitmap->word_count) {
+        if (FLAG_CHECK(bitmap, COUNTED)) {
+            bitmap->set_count -= __builtin_popcountll(word_load_masked(bitmap, word, 0));
+        }
+        word_store(bitmap, word, value);
+        if (FLAG_CHECK(bitmap, COUNTED)) {
+            bitmap->set_count += __builtin_popcountll(word_load_masked(bitmap, word, 0));
+        }
+        if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+            bitmap_touch(bitmap, word, word);
+        }
+    }
 }
 
 void bitmap_invert(bitmap_t *const bitmap) {
-    for (size_t byte = 0; byte < bitmap->byte_count; ++byte) {
+    // Whole words go to the kernel, an overlay that ends mid-word gets the last few bytes by hand
+    kernels.invert(bitmap->data, bitmap->full_words);
+    for (size_t byte = bitmap->full_words * WORD_BYTES; byte < bitmap->byte_count; ++byte) {
         bitmap->data[byte] = ~bitmap->data[byte];
     }
+    // Words with something set are now words with something clear, and vice versa
+    uint64_t *const has_set = bitmap->has_set;
+    bitmap->has_set = bitmap->has_clear;
+    bitmap->has_clear = has_set;
+    if (FLAG_CHECK(bitmap, RANKED)) {
+        bitmap->rank->stale_from = 0;
+    }
+    // Everything that was clear is now set
+    bitmap->set_count = bitmap->bit_count - bitmap->set_count;
 }
 
 size_t bitmap_ffs(const bitmap_t *const bitmap) {
-    if (bitmap) {
-        size_t result = 0;
-        for (; result < bitmap->bit_count && !bitmap_test(bitmap, result); ++result) {}
-        return (result == bitmap->bit_count ? SIZE_MAX : result);
+    return bitmap_scan_forward(bitmap, 0, SIZE_MAX, 0);
+}
+
+size_t bitmap_ffz(const bitmap_t *const bitmap) {
+    return bitmap_scan_forward(bitmap, 0, SIZE_MAX, ~((uint64_t) 0));
+}
+
+size_t bitmap_ffs_from(const bitmap_t *const bitmap, const size_t bit) {
+    return bitmap_scan_forward(bitmap, bit, SIZE_MAX, 0);
+}
+
+size_t bitmap_ffz_from(const bitmap_t *const bitmap, const size_t bit) {
+    return bitmap_scan_forward(bitmap, bit, SIZE_MAX, ~((uint64_t) 0));
+}
+
+size_t bitmap_fls(const bitmap_t *const bitmap) {
+    return bitmap_scan_backward(bitmap, SIZE_MAX, 0);
+}
+
+size_t bitmap_flz(const bitmap_t *const bitmap) {
+    return bitmap_scan_backward(bitmap, SIZE_MAX, ~((uint64_t) 0));
+}
+
+size_t bitmap_fls_before(const bitmap_t *const bitmap, const size_t bit) {
+    return bitmap_scan_backward(bitmap, bit, 0);
+}
+
+size_t bitmap_flz_before(const bitmap_t *const bitmap, const size_t bit) {
+    return bitmap_scan_backward(bitmap, bit, ~((uint64_t) 0));
+}
+
+void bitmap_set_range(bitmap_t *const bitmap, const size_t start, const size_t end) {
+    bitmap_fill_range(bitmap, start, end, true);
+}
+
+void bitmap_reset_range(bitmap_t *const bitmap, const size_t start, const size_t end) {
+    bitmap_fill_range(bitmap, start, end, false);
+}
+
+bool bitmap_test_range_all(const bitmap_t *const bitmap, const size_t start, const size_t end) {
+    if (bitmap && start < end && end <= bitmap->bit_count) {
+        const size_t last = (end - 1) >> WORD_SHIFT;
+        for (size_t word = start >> WORD_SHIFT; word <= last; ++word) {
+            const uint64_t mask = word_range_mask(word, start, end);
+            if ((word_load(bitmap, word) & mask) != mask) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool bitmap_test_range_any(const bitmap_t *const bitmap, const size_t start, const size_t end) {
+    if (bitmap && start < end && end <= bitmap->bit_count) {
+        const size_t last = (end - 1) >> WORD_SHIFT;
+        for (size_t word = start >> WORD_SHIFT; word <= last; ++word) {
+            if (word_load(bitmap, word) & word_range_mask(word, start, end)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t bitmap_count_range(const bitmap_t *const bitmap, const size_t start, const size_t end) {
+    size_t total = 0;
+    if (bitmap && start < end && end <= bitmap->bit_count) {
+        // Partial words on either side, the kernel takes the whole ones between
+        const size_t first = start >> WORD_SHIFT;
+        const size_t last = (end - 1) >> WORD_SHIFT;
+        total = __builtin_popcountll(word_load(bitmap, first) & word_range_mask(first, start, end));
+        if (last > first) {
+            total += kernels.popcount(bitmap->data + ((first + 1) * WORD_BYTES), last - first - 1);
+            total += __builtin_popcountll(word_load(bitmap, last) & word_range_mask(last, start, end));
+        }
+    }
+    return total;
+}
+
+bool bitmap_and(bitmap_t *const bitmap, const bitmap_t *const other) {
+    return bitmap_combine(bitmap, bitmap, other, OP_AND);
+}
+
+bool bitmap_and_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b) {
+    return bitmap_combine(dest, a, b, OP_AND);
+}
+
+bool bitmap_or(bitmap_t *const bitmap, const bitmap_t *const other) {
+    return bitmap_combine(bitmap, bitmap, other, OP_OR);
+}
+
+bool bitmap_or_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b) {
+    return bitmap_combine(dest, a, b, OP_OR);
+}
+
+bool bitmap_xor(bitmap_t *const bitmap, const bitmap_t *const other) {
+    return bitmap_combine(bitmap, bitmap, other, OP_XOR);
+}
+
+bool bitmap_xor_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b) {
+    return bitmap_combine(dest, a, b, OP_XOR);
+}
+
+bool bitmap_andnot(bitmap_t *const bitmap, const bitmap_t *const other) {
+    return bitmap_combine(bitmap, bitmap, other, OP_ANDNOT);
+}
+
+bool bitmap_andnot_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b) {
+    return bitmap_combine(dest, a, b, OP_ANDNOT);
+}
+
+bool bitmap_equal(const bitmap_t *const a, const bitmap_t *const b) {
+    // Same size and nothing differs
+    return a && b && a->bit_count == b->bit_count && !bitmap_combine_any(a, b, OP_XOR);
+}
+
+bool bitmap_intersects(const bitmap_t *const a, const bitmap_t *const b) {
+    return a && b && a->bit_count == b->bit_count && bitmap_combine_any(a, b, OP_AND);
+}
+
+size_t bitmap_find_zero_run(const bitmap_t *const bitmap, const size_t n_bits, const size_t hint) {
+    if (bitmap && n_bits && n_bits <= bitmap->bit_count) {
+        if (hint < bitmap->bit_count) {
+            const size_t chunks = bitmap_parallel_chunks(bitmap->word_count - (hint >> WORD_SHIFT));
+            if (chunks) {
+                return bitmap_zero_run_parallel(bitmap, n_bits, hint, NULL, chunks);
+            }
+        }
+        // Hop to the next zero (full words get skipped there), then see how far the zeroes go.
+        // We only care about the next n_bits, so don't look any further than that
+        size_t start = bitmap_ffz_from(bitmap, hint);
+        while (start != SIZE_MAX && (bitmap->bit_count - start) >= n_bits) {
+            const size_t blocker = bitmap_scan_forward(bitmap, start, start + n_bits, 0);
+            if (blocker == SIZE_MAX) {
+                return start;
+            }
+            start = bitmap_ffz_from(bitmap, blocker + 1);
+        }
     }
     return SIZE_MAX;
 }
 
-size_t bitmap_ffz(const bitmap_t *const bitmap) {
+size_t bitmap_longest_zero_run(const bitmap_t *const bitmap, size_t *const run_start) {
+    size_t longest = 0, longest_start = SIZE_MAX;
     if (bitmap) {
-        size_t result = 0;
-        for (; result < bitmap->bit_count && bitmap_test(bitmap, result); ++result) {}
-        return (result == bitmap->bit_count ? SIZE_MAX : result);
+        const size_t chunks = bitmap_parallel_chunks(bitmap->word_count);
+        if (chunks) {
+            return bitmap_zero_run_parallel(bitmap, 0, 0, run_start, chunks);
+        }
+        size_t start = bitmap_ffz(bitmap);
+        // No point looking at a run that starts too late to beat what we have
+        while (start != SIZE_MAX && (bitmap->bit_count - start) > longest) {
+            size_t end = bitmap_ffs_from(bitmap, start);
+            if (end == SIZE_MAX) {
+                end = bitmap->bit_count;
+            }
+            if (end - start > longest) {
+                longest = end - start;
+                longest_start = start;
+            }
+            start = bitmap_ffz_from(bitmap, end);
+        }
+    }
+    if (run_start) {
+        *run_start = longest_start;
+    }
+    return longest;
+}
+
+bool bitmap_test_and_set(bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap && bit < bitmap->bit_count) {
+        uint64_t *const word = atomic_word(bitmap, bit >> WORD_SHIFT);
+        bool previous;
+        if (word) {
+            const uint64_t bit_mask = WORD_TO_LE(((uint64_t) 1) << (bit & WORD_MASK));
+            previous = __atomic_fetch_or(word, bit_mask, __ATOMIC_ACQ_REL) & bit_mask;
+        } else {
+            previous = __atomic_fetch_or(bitmap->data + (bit >> 3), mask[bit & 0x07], __ATOMIC_ACQ_REL) & mask[bit & 0x07];
+        }
+        if (!previous) {
+            if (FLAG_CHECK(bitmap, COUNTED)) {
+                __atomic_fetch_add(&bitmap->set_count, 1, __ATOMIC_RELAXED);
+            }
+            if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+                bitmap_atomic_touch(bitmap, bit >> WORD_SHIFT);
+            }
+        }
+        return previous;
+    }
+    return false;
+}
+
+bool bitmap_test_and_reset(bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap && bit < bitmap->bit_count) {
+        uint64_t *const word = atomic_word(bitmap, bit >> WORD_SHIFT);
+        bool previous;
+        if (word) {
+            const uint64_t bit_mask = WORD_TO_LE(((uint64_t) 1) << (bit & WORD_MASK));
+            previous = __atomic_fetch_and(word, ~bit_mask, __ATOMIC_ACQ_REL) & bit_mask;
+        } else {
+            previous = __atomic_fetch_and(bitmap->data + (bit >> 3), invert_mask[bit & 0x07], __ATOMIC_ACQ_REL) & mask[bit & 0x07];
+        }
+        if (previous) {
+            if (FLAG_CHECK(bitmap, COUNTED)) {
+                __atomic_fetch_sub(&bitmap->set_count, 1, __ATOMIC_RELAXED);
+            }
+            if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+                bitmap_atomic_touch(bitmap, bit >> WORD_SHIFT);
+            }
+        }
+        return previous;
+    }
+    return false;
+}
+
+size_t bitmap_ffz_and_claim(bitmap_t *const bitmap, const size_t hint) {
+    if (bitmap) {
+        // Hint to the end, then wrap around for the part we skipped
+        const size_t start = hint < bitmap->bit_count ? hint : 0;
+        const size_t claimed = bitmap_claim_forward(bitmap, start, bitmap->bit_count);
+        return (claimed == SIZE_MAX && start) ? bitmap_claim_forward(bitmap, 0, start) : claimed;
     }
     return SIZE_MAX;
 }
 
 size_t bitmap_total_set(const bitmap_t *const bitmap) {
-    size_t total = 0;
     if (bitmap) {
-        // If we have leftover, stop a byte early because we have to handle it differently.
-        size_t stop = bitmap->leftover_bits ? bitmap->byte_count - 1 : bitmap->byte_count;
-        for (size_t idx = 0; idx < stop; ++idx) {
-            total += bit_totals[bitmap->data[idx]];
-        }
-        if (bitmap->leftover_bits) {
-            // haha, this is readable
-            // get the byte at the end of the bitmap, mask it so we're only looking at the bits in use
-            // then feed that to the bit_total lookup so we don't count the bits past our bit total
-            // (which whould be considered undetermined)
-            total += bit_totals[bitmap->data[bitmap->byte_count - 1] & mask_down_inclusive[bitmap->leftover_bits - 1]];
-        }
+        return FLAG_CHECK(bitmap, COUNTED) ? bitmap->set_count : bitmap_popcount(bitmap);
     }
-    return total;
+    return 0;
 }
 
 void bitmap_for_each(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args) {
     if (bitmap && func) {
-        for (size_t idx = 0; idx < bitmap->bit_count; ++idx) {
-            if (bitmap_test(bitmap, idx)) {
-                func(idx, args);
+        // Jump to the next word with anything in it, then peel its bits off lowest first
+        for (size_t bit = bitmap_ffs(bitmap); bit != SIZE_MAX; bit = bitmap_ffs_from(bitmap, bit)) {
+            const size_t word = bit >> WORD_SHIFT;
+            uint64_t value = word_load_masked(bitmap, word, 0) & (~((uint64_t) 0) << (bit & WORD_MASK));
+            while (value) {
+                func((word << WORD_SHIFT) + WORD_CTZ(value), args);
+                value &= value - 1;
             }
+            bit = (word + 1) << WORD_SHIFT;
+        }
+    }
+}
+
+void bitmap_for_each_unordered(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args) {
+    if (bitmap && func) {
+        const size_t chunks = bitmap_parallel_chunks(bitmap->word_count);
+        if (chunks) {
+            bitmap_for_each_parallel(bitmap, func, args, chunks);
+        } else {
+            bitmap_for_each(bitmap, func, args);
         }
     }
 }
 
+void bitmap_set_threads(const size_t threads) {
+    __atomic_store_n(&bitmap_threads, threads, __ATOMIC_RELAXED);
+}
+
+size_t bitmap_extract_set(const bitmap_t *const bitmap, size_t *const out_indices, const size_t max, size_t *const cursor) {
+    size_t count = 0;
+    if (bitmap && out_indices && cursor) {
+        // Same word peeling as for_each, but we have to be able to stop partway through a word
+        size_t bit = *cursor;
+        while (count < max && (bit = bitmap_ffs_from(bitmap, bit)) != SIZE_MAX) {
+            const size_t word = bit >> WORD_SHIFT;
+            uint64_t value = word_load_masked(bitmap, word, 0) & (~((uint64_t) 0) << (bit & WORD_MASK));
+            do {
+                out_indices[count++] = (word << WORD_SHIFT) + WORD_CTZ(value);
+                value &= value - 1;
+            } while (value && count < max);
+            bit = value ? (word << WORD_SHIFT) + WORD_CTZ(value) : (word + 1) << WORD_SHIFT;
+        }
+        *cursor = bit < bitmap->bit_count ? bit : bitmap->bit_count;
+    }
+    return count;
+}
+
+bool bitmap_next_run(const bitmap_t *const bitmap, size_t *const pos, size_t *const start, size_t *const length) {
+    if (bitmap && pos && start && length) {
+        // Run starts at the next set bit and goes until the next clear one (or the end)
+        const size_t run_start = bitmap_ffs_from(bitmap, *pos);
+        if (run_start != SIZE_MAX) {
+            size_t run_end = bitmap_ffz_from(bitmap, run_start);
+            run_end = (run_end == SIZE_MAX) ? bitmap->bit_count : run_end;
+            *start = run_start;
+            *length = run_end - run_start;
+            *pos = run_end;
+            return true;
+        }
+        *pos = bitmap->bit_count;
+    }
+    return false;
+}
+
 void bitmap_format(bitmap_t *const bitmap, const uint8_t pattern) {
     memset(bitmap->data, pattern, bitmap->byte_count);
+    if (FLAG_CHECK(bitmap, COUNTED)) {
+        // Every whole byte has the pattern's bits, then whatever part of it the last byte gets to keep
+        bitmap->set_count = (bitmap->bit_count >> 3) * __builtin_popcount(pattern);
+        bitmap->set_count += __builtin_popcount(pattern & ((1u << bitmap->leftover_bits) - 1));
+    }
+    if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+        bitmap_touch(bitmap, 0, bitmap->word_count - 1);
+    }
 }
 
 size_t bitmap_get_bits(const bitmap_t *const bitmap) {
@@ -169,9 +970,168 @@ bitmap_t *bitmap_overlay(const size_t n_bits, void *const bitmap_data) {
     return NULL;
 }
 
+bitmap_t *bitmap_map_file(const char *const path, const size_t n_bits, const BITMAP_MAP_FLAGS flags) {
+    if (path) {
+        // It's an overlay as far as everything else is concerned, we just own the mapping
+        bitmap_t *bitmap = bitmap_initialize(n_bits, OVERLAY | MAPPED);
+        if (bitmap) {
+            const int fd = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP);
+            if (fd != -1) {
+                struct stat file_stat;
+                // Grow (never shrink) the file to fit, the new part reads as zeros
+                if (!fstat(fd, &file_stat)
+                    && ((size_t) file_stat.st_size >= bitmap->byte_count || !ftruncate(fd, bitmap->byte_count))) {
+                    int map_flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+                    if (flags & BITMAP_MAP_POPULATE) {
+                        map_flags |= MAP_POPULATE;
+                    }
+#endif
+                    void *const data = mmap(NULL, bitmap->byte_count, PROT_READ | PROT_WRITE, map_flags, fd, 0);
+                    if (data != MAP_FAILED) {
+                        // The mapping holds its own reference to the file
+                        close(fd);
+                        bitmap->data = (uint8_t *) data;
+                        return bitmap;
+                    }
+                }
+                close(fd);
+            }
+            free(bitmap);
+        }
+    }
+    return NULL;
+}
+
+bool bitmap_sync(bitmap_t *const bitmap, const bool wait) {
+    if (bitmap) {
+        if (FLAG_CHECK(bitmap, MAPPED)) {
+            return !msync(bitmap->data, bitmap->byte_count, wait ? MS_SYNC : MS_ASYNC);
+        }
+        // Nothing to write back
+        return true;
+    }
+    return false;
+}
+
+bool bitmap_summarize(bitmap_t *const bitmap) {
+    if (bitmap) {
+        if (!FLAG_CHECK(bitmap, SUMMARY)) {
+            const size_t summary_words = WORD_COUNT(bitmap->word_count);
+            bitmap->summary = (uint64_t *) calloc(summary_words * 2, sizeof(uint64_t));
+            if (!bitmap->summary) {
+                return false;
+            }
+            bitmap->has_set = bitmap->summary;
+            bitmap->has_clear = bitmap->summary + summary_words;
+            bitmap->flags |= SUMMARY;
+        }
+        bitmap_summary_rebuild(bitmap, 0, bitmap->word_count - 1);
+        return true;
+    }
+    return false;
+}
+
+bool bitmap_track_count(bitmap_t *const bitmap) {
+    if (bitmap) {
+        // One count up front (that's the resync for overlays), then every write keeps it going
+        bitmap->set_count = bitmap_popcount(bitmap);
+        bitmap->flags |= COUNTED;
+        return true;
+    }
+    return false;
+}
+
+bool bitmap_build_rank_index(bitmap_t *const bitmap) {
+    if (bitmap) {
+        if (!FLAG_CHECK(bitmap, RANKED)) {
+            const size_t superblocks = (bitmap->word_count + RANK_SUPERBLOCK_WORDS - 1) >> RANK_SUPERBLOCK_SHIFT;
+            bitmap->rank = (rank_index_t *) malloc(sizeof(rank_index_t) + ((superblocks + 1) * sizeof(size_t)));
+            if (!bitmap->rank) {
+                return false;
+            }
+            bitmap->rank->superblocks = superblocks;
+            bitmap->rank->counts[0] = 0;
+            bitmap->flags |= RANKED;
+        }
+        bitmap->rank->stale_from = 0;
+        bitmap_rank_refresh(bitmap);
+        return true;
+    }
+    return false;
+}
+
+size_t bitmap_rank(const bitmap_t *const bitmap, const size_t bit) {
+    if (bitmap) {
+        const size_t end = bit < bitmap->bit_count ? bit : bitmap->bit_count;
+        if (!FLAG_CHECK(bitmap, RANKED)) {
+            // No index, count the hard way
+            return bitmap_count_range(bitmap, 0, end);
+        }
+        bitmap_rank_refresh(bitmap);
+        // Superblock count, then at most 8 more words
+        const size_t last_word = end >> WORD_SHIFT;
+        size_t word = (last_word >> RANK_SUPERBLOCK_SHIFT) << RANK_SUPERBLOCK_SHIFT;
+        size_t total = bitmap->rank->counts[word >> RANK_SUPERBLOCK_SHIFT];
+        for (; word < last_word; ++word) {
+            total += __builtin_popcountll(word_load(bitmap, word));
+        }
+        if (end & WORD_MASK) {
+            total += __builtin_popcountll(word_load(bitmap, word) & (~((uint64_t) 0) >> (64 - (end & WORD_MASK))));
+        }
+        return total;
+    }
+    return 0;
+}
+
+size_t bitmap_select(const bitmap_t *const bitmap, const size_t k) {
+    if (bitmap) {
+        size_t word = 0, remaining = k;
+        if (FLAG_CHECK(bitmap, RANKED)) {
+            bitmap_rank_refresh(bitmap);
+            const size_t *const counts = bitmap->rank->counts;
+            if (k >= counts[bitmap->rank->superblocks]) {
+                return SIZE_MAX;
+            }
+            // Last superblock that starts with k or fewer bits before it
+            size_t first = 0, size = bitmap->rank->superblocks;
+            while (size > 1) {
+                const size_t half = size >> 1;
+                if (counts[first + half] <= k) {
+                    first += half;
+                    size -= half;
+                } else {
+                    size = half;
+                }
+            }
+            word = first << RANK_SUPERBLOCK_SHIFT;
+            remaining = k - counts[first];
+        }
+        // Walk words until the one holding it, then drop the lower set bits in that word
+        for (; word < bitmap->word_count; ++word) {
+            uint64_t value = word_load_masked(bitmap, word, 0);
+            const size_t total = __builtin_popcountll(value);
+            if (remaining < total) {
+                while (remaining--) {
+                    value &= value - 1;
+                }
+                return (word << WORD_SHIFT) + WORD_CTZ(value);
+            }
+            remaining -= total;
+        }
+    }
+    return SIZE_MAX;
+}
+
 void bitmap_destroy(bitmap_t *bitmap) {
     if (bitmap) {
-        if (!FLAG_CHECK(bitmap, OVERLAY)) {
+        free(bitmap->summary);
+        free(bitmap->rank);
+        if (FLAG_CHECK(bitmap, MAPPED)) {
+            // munmap alone leaves the dirty pages to the page cache, get them on disk first
+            msync(bitmap->data, bitmap->byte_count, MS_SYNC);
+            munmap(bitmap->data, bitmap->byte_count);
+        } else if (!FLAG_CHECK(bitmap, OVERLAY)) {
             // don't free memory that isn't ours!
             free(bitmap->data);
         }
@@ -194,6 +1154,13 @@ bitmap_t *bitmap_initialize(size_t n_bits, BITMAP_FLAGS flags) {
             bitmap->byte_count = n_bits >> 3;
             bitmap->leftover_bits = n_bits & 0x07;
             bitmap->byte_count += (bitmap->leftover_bits ? 1 : 0);
+            bitmap->word_count = WORD_COUNT(n_bits);
+            // We allocate whole words, so all of ours are loadable. Overlays only promise byte_count.
+            bitmap->full_words = FLAG_CHECK(bitmap, OVERLAY) ? (bitmap->byte_count / WORD_BYTES) : bitmap->word_count;
+            // bitmap_summarize sets these up if asked
+            bitmap->summary = bitmap->has_set = bitmap->has_clear = NULL;
+            bitmap->rank = NULL;
+            bitmap->set_count = 0;
 
             // FLAG HANDLING HERE
 
@@ -206,7 +1173,8 @@ bitmap_t *bitmap_initialize(size_t n_bits, BITMAP_FLAGS flags) {
                 bitmap->data = NULL;
                 return bitmap;
             } else {
-                bitmap->data = (uint8_t *)calloc(bitmap->byte_count, 1);
+                // Rounded up to whole words so the word routines never have to special-case us
+                bitmap->data = (uint8_t *)calloc(bitmap->word_count, WORD_BYTES);
                 if (bitmap->data) {
                     return bitmap;
                 }
@@ -217,3 +1185,451 @@ bitmap_t *bitmap_initialize(size_t n_bits, BITMAP_FLAGS flags) {
     }
     return NULL;
 }
+
+void bitmap_fill_range(bitmap_t *const bitmap, const size_t start, const size_t end, const bool value) {
+    if (bitmap && start < end && end <= bitmap->bit_count) {
+        if (FLAG_CHECK(bitmap, COUNTED)) {
+            // Swap what was in the range for what will be
+            bitmap->set_count -= bitmap_count_range(bitmap, start, end);
+            bitmap->set_count += value ? end - start : 0;
+        }
+        const size_t first = start >> WORD_SHIFT, last = (end - 1) >> WORD_SHIFT;
+        // Partial words on the ends get a read-modify-write
+        // Everything between them is whole words, and since every word but the last is fully
+        // backed, the middle is just a memset (the byte layout doesn't care about endianness for 0x00/0xFF)
+        uint64_t mask = word_range_mask(first, start, end);
+        word_store(bitmap, first, value ? (word_load(bitmap, first) | mask) : (word_load(bitmap, first) & ~mask));
+        if (first != last) {
+            if (last - first > 1) {
+                memset(bitmap->data + ((first + 1) * WORD_BYTES), value ? 0xFF : 0x00, (last - first - 1) * WORD_BYTES);
+            }
+            mask = word_range_mask(last, start, end);
+            word_store(bitmap, last, value ? (word_load(bitmap, last) | mask) : (word_load(bitmap, last) & ~mask));
+        }
+        if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+            bitmap_touch(bitmap, first, last);
+        }
+    }
+}
+
+size_t bitmap_scan_forward(const bitmap_t *const bitmap, const size_t bit, const size_t end, const uint64_t invert) {
+    if (bitmap && bit < end && bit < bitmap->bit_count) {
+        // Knock off the bits below our start in the first word, then skip words until something shows up
+        // We may find something in the last word that's past the end, so check before we return it
+        const size_t stop = (end > bitmap->bit_count ? bitmap->bit_count : end);
+        const size_t last_word = (stop - 1) >> WORD_SHIFT;
+        size_t word = bit >> WORD_SHIFT;
+        uint64_t value = word_load_masked(bitmap, word, invert) & (~((uint64_t) 0) << (bit & WORD_MASK));
+        if (!value && FLAG_CHECK(bitmap, SUMMARY)) {
+            // The summary knows exactly which word is next, skip straight to it
+            word = summary_next(invert ? bitmap->has_clear : bitmap->has_set, word + 1, last_word);
+            if (word == SIZE_MAX) {
+                return SIZE_MAX;
+            }
+            value = word_load_masked(bitmap, word, invert);
+        } else if (!value) {
+            // Hand the run of words before the last one to the kernel (they're all full words)
+            if (++word < last_word) {
+                word += kernels.scan(bitmap->data + (word * WORD_BYTES), last_word - word, invert);
+            }
+            while (word <= last_word && !(value = word_load_masked(bitmap, word, invert))) {
+                ++word;
+            }
+            if (!value) {
+                return SIZE_MAX;
+            }
+        }
+        const size_t result = (word << WORD_SHIFT) + WORD_CTZ(value);
+        return result < stop ? result : SIZE_MAX;
+    }
+    return SIZE_MAX;
+}
+
+size_t bitmap_claim_forward(bitmap_t *const bitmap, size_t bit, const size_t end) {
+    while (bit < end) {
+        size_t word = bit >> WORD_SHIFT;
+        if (FLAG_CHECK(bitmap, SUMMARY)) {
+            // Skip straight to the next word that has something to claim
+            const size_t next = summary_next(bitmap->has_clear, word, (end - 1) >> WORD_SHIFT);
+            if (next == SIZE_MAX) {
+                return SIZE_MAX;
+            }
+            if (next != word) {
+                word = next;
+                bit = word << WORD_SHIFT;
+            }
+        }
+        uint64_t *const position = atomic_word(bitmap, word);
+        if (position) {
+            // Pick the lowest clear candidate and try to CAS it in
+            // A failed CAS hands back the new value, so we just go again with whatever is left
+            const uint64_t candidates = word_range_mask(word, bit, end);
+            uint64_t value = __atomic_load_n(position, __ATOMIC_RELAXED);
+            uint64_t clear;
+            while ((clear = ~WORD_FROM_LE(value) & candidates)) {
+                const uint64_t claim = clear & (~clear + 1);
+                if (__atomic_compare_exchange_n(position, &value, value | WORD_TO_LE(claim), true,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                    if (FLAG_CHECK(bitmap, COUNTED)) {
+                        __atomic_fetch_add(&bitmap->set_count, 1, __ATOMIC_RELAXED);
+                    }
+                    if (FLAG_CHECK(bitmap, AUX_FLAGS)) {
+                        bitmap_atomic_touch(bitmap, word);
+                    }
+                    return (word << WORD_SHIFT) + WORD_CTZ(claim);
+                }
+            }
+        } else {
+            // Partial or misaligned word (only overlays), bit at a time
+            for (size_t candidate = bit; candidate < end && (candidate >> WORD_SHIFT) == word; ++candidate) {
+                if (!bitmap_test_and_set(bitmap, candidate)) {
+                    return candidate;
+                }
+            }
+        }
+        bit = (word + 1) << WORD_SHIFT;
+    }
+    return SIZE_MAX;
+}
+
+bool bitmap_combine(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b, const BITMAP_OP op) {
+    if (dest && a && b && dest->bit_count == a->bit_count && a->bit_count == b->bit_count) {
+        // The kernel gets every word all three can load directly, which is all of them unless an overlay
+        // ends mid-word. That last word goes through the byte-safe load/store.
+        size_t full_words = dest->full_words < a->full_words ? dest->full_words : a->full_words;
+        full_words = full_words < b->full_words ? full_words : b->full_words;
+        kernels.combine(dest->data, a->data, b->data, full_words, op);
+        for (size_t word = full_words; word < dest->word_count; ++word) {
+            word_store(dest, word, word_combine(word_load(a, word), word_load(b, word), op));
+        }
+        if (FLAG_CHECK(dest, AUX_FLAGS)) {
+            bitmap_touch(dest, 0, dest->word_count - 1);
+        }
+        if (FLAG_CHECK(dest, COUNTED)) {
+            dest->set_count = bitmap_popcount(dest);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool bitmap_combine_any(const bitmap_t *const a, const bitmap_t *const b, const BITMAP_OP op) {
+    // Every word before the last is fully backed, the last one needs its undetermined bits masked off
+    const size_t last = a->word_count - 1;
+    if (kernels.compare(a->data, b->data, last, op) < last) {
+        return true;
+    }
+    return word_combine(word_load(a, last), word_load(b, last), op) & word_tail_mask(a);
+}
+
+// Per-chunk popcounts, added up once everybody's done
+typedef struct {
+    const bitmap_t *bitmap;
+    size_t n_words, chunks;
+    size_t counts[BITMAP_MAX_CHUNKS];
+} popcount_job_t;
+
+// Words [first, last) of chunk out of chunks covering n_words
+static inline void chunk_span(const size_t n_words, const size_t chunks, const size_t chunk, size_t *const first, size_t *const last) {
+    const size_t per_chunk = (n_words + chunks - 1) / chunks;
+    *first = chunk * per_chunk < n_words ? chunk * per_chunk : n_words;
+    *last = *first + per_chunk < n_words ? *first + per_chunk : n_words;
+}
+
+static void popcount_job(void *const ctx, const size_t chunk) {
+    popcount_job_t *const job = (popcount_job_t *) ctx;
+    size_t first, last;
+    chunk_span(job->n_words, job->chunks, chunk, &first, &last);
+    job->counts[chunk] = kernels.popcount(job->bitmap->data + (first * WORD_BYTES), last - first);
+}
+
+size_t bitmap_popcount(const bitmap_t *const bitmap) {
+    // Everything but the last word goes to the kernel (split up if it's big)
+    // The last word gets masked so we don't count the bits past our bit total
+    // (which whould be considered undetermined)
+    const size_t last = bitmap->word_count - 1;
+    const size_t chunks = bitmap_parallel_chunks(last);
+    size_t total = 0;
+    if (chunks) {
+        popcount_job_t job = {bitmap, last, chunks, {0}};
+        bitmap_parallel(chunks, &popcount_job, &job);
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            total += job.counts[chunk];
+        }
+    } else {
+        total = kernels.popcount(bitmap->data, last);
+    }
+    total += __builtin_popcountll(word_load_masked(bitmap, last, 0));
+    return total;
+}
+
+// Whoever's handing out chunks, the threads just keep taking the next one
+typedef struct {
+    void (*job)(void *const, const size_t);
+    void *ctx;
+    size_t chunks, next;
+} bitmap_pool_t;
+
+static void *bitmap_worker(void *arg) {
+    bitmap_pool_t *const pool = (bitmap_pool_t *) arg;
+    size_t chunk;
+    while ((chunk = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->chunks) {
+        pool->job(pool->ctx, chunk);
+    }
+    return NULL;
+}
+
+// Resolves the thread setting, 0 is one per CPU
+static size_t bitmap_thread_count(void) {
+    size_t threads = __atomic_load_n(&bitmap_threads, __ATOMIC_RELAXED);
+    if (!threads) {
+        threads = bitmap_cpus;
+    }
+    return threads < BITMAP_MAX_THREADS ? threads : BITMAP_MAX_THREADS;
+}
+
+size_t bitmap_parallel_chunks(const size_t n_words) {
+    // Size first, this is on every small scan's path (block_store allocations) and should cost nothing there
+    if (n_words < BITMAP_PARALLEL_MIN_WORDS) {
+        return 0;
+    }
+    const size_t threads = bitmap_thread_count();
+    if (threads > 1) {
+        // A few chunks per thread so one slow chunk doesn't hold everybody up
+        const size_t chunks = threads * BITMAP_CHUNKS_PER_THREAD;
+        return chunks < n_words ? chunks : n_words;
+    }
+    return 0;
+}
+
+void bitmap_parallel(const size_t chunks, void (*job)(void *const, const size_t), void *const ctx) {
+    bitmap_pool_t pool = {job, ctx, chunks, 0};
+    pthread_t workers[BITMAP_MAX_THREADS];
+    const size_t threads = bitmap_thread_count() < chunks ? bitmap_thread_count() : chunks;
+    size_t started = 0;
+    // We're one of the threads. If one doesn't start, the rest just end up with more chunks each
+    while (started + 1 < threads && !pthread_create(workers + started, NULL, &bitmap_worker, &pool)) {
+        ++started;
+    }
+    bitmap_worker(&pool);
+    for (size_t worker = 0; worker < started; ++worker) {
+        pthread_join(workers[worker], NULL);
+    }
+}
+
+typedef struct {
+    const bitmap_t *bitmap;
+    void (*func)(size_t, void *);
+    void *args;
+    size_t chunks;
+} for_each_job_t;
+
+static void for_each_job(void *const ctx, const size_t chunk) {
+    const for_each_job_t *const job = (const for_each_job_t *) ctx;
+    const bitmap_t *const bitmap = job->bitmap;
+    size_t first, last;
+    chunk_span(bitmap->word_count, job->chunks, chunk, &first, &last);
+    // Same word peeling as for_each, kept inside our words
+    const size_t end = last << WORD_SHIFT;
+    for (size_t bit = bitmap_scan_forward(bitmap, first << WORD_SHIFT, end, 0); bit != SIZE_MAX;
+         bit = bitmap_scan_forward(bitmap, bit, end, 0)) {
+        const size_t word = bit >> WORD_SHIFT;
+        uint64_t value = word_load_masked(bitmap, word, 0) & (~((uint64_t) 0) << (bit & WORD_MASK));
+        while (value) {
+            job->func((word << WORD_SHIFT) + WORD_CTZ(value), job->args);
+            value &= value - 1;
+        }
+        bit = (word + 1) << WORD_SHIFT;
+    }
+}
+
+void bitmap_for_each_parallel(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args, const size_t chunks) {
+    for_each_job_t job = {bitmap, func, args, chunks};
+    bitmap_parallel(chunks, &for_each_job, &job);
+}
+
+// What a chunk knows about its zero runs, for stitching the runs that cross chunks back together
+//  prefix/suffix - clear bits at the start/end of the chunk (prefix is the chunk length if it's all clear)
+//  best_start/best_length - the first run of at least n_bits, or the longest run (when n_bits is 0)
+typedef struct {
+    size_t prefix, suffix, best_start, best_length;
+} zero_run_chunk_t;
+
+typedef struct {
+    const bitmap_t *bitmap;
+    size_t n_bits, start, per_chunk, chunks;
+    // Lowest chunk with a fit so far, later chunks can't win so they don't bother
+    size_t found;
+    zero_run_chunk_t results[BITMAP_MAX_CHUNKS];
+} zero_run_job_t;
+
+static void zero_run_job(void *const ctx, const size_t chunk) {
+    zero_run_job_t *const job = (zero_run_job_t *) ctx;
+    const bitmap_t *const bitmap = job->bitmap;
+    zero_run_chunk_t *const result = job->results + chunk;
+    const size_t start = job->start + (chunk * job->per_chunk);
+    *result = (zero_run_chunk_t) {0, 0, SIZE_MAX, 0};
+    // Rounding can leave the last chunk or two with nothing to do
+    if (start >= bitmap->bit_count || (job->n_bits && __atomic_load_n(&job->found, __ATOMIC_RELAXED) < chunk)) {
+        return;
+    }
+    const size_t end = (bitmap->bit_count - start) > job->per_chunk ? start + job->per_chunk : bitmap->bit_count;
+    // Walk the runs in the chunk, clipped to it
+    size_t run = bitmap_scan_forward(bitmap, start, end, ~((uint64_t) 0));
+    while (run != SIZE_MAX) {
+        size_t run_end = bitmap_scan_forward(bitmap, run, end, 0);
+        run_end = (run_end == SIZE_MAX ? end : run_end);
+        result->prefix = (run == start ? run_end - run : result->prefix);
+        result->suffix = (run_end == end ? run_end - run : 0);
+        if (job->n_bits ? (run_end - run >= job->n_bits) : (run_end - run > result->best_length)) {
+            result->best_start = run;
+            result->best_length = run_end - run;
+            if (job->n_bits) {
+                // First fit is all we need, the merge won't look at our suffix
+                size_t found = __atomic_load_n(&job->found, __ATOMIC_RELAXED);
+                while (chunk < found && !__atomic_compare_exchange_n(&job->found, &found, chunk, true,
+                                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                }
+                return;
+            }
+        }
+        run = (run_end < end ? bitmap_scan_forward(bitmap, run_end, end, ~((uint64_t) 0)) : SIZE_MAX);
+    }
+}
+
+size_t bitmap_zero_run_parallel(const bitmap_t *const bitmap, const size_t n_bits, const size_t hint, size_t *const run_start,
+                                const size_t chunks) {
+    // Chunks are a whole number of words long, counting from the hint
+    const size_t span = bitmap->bit_count - hint;
+    zero_run_job_t job = {bitmap, n_bits, hint, ((WORD_COUNT(span) + chunks - 1) / chunks) << WORD_SHIFT, chunks, SIZE_MAX, {{0}}};
+    size_t longest = 0, longest_start = SIZE_MAX;
+    bitmap_parallel(chunks, &zero_run_job, &job);
+
+    // Stitch it together in order, open_* is the run still going at the end of the last chunk
+    size_t open_start = SIZE_MAX, open_length = 0, result = SIZE_MAX;
+    for (size_t chunk = 0; chunk < chunks && result == SIZE_MAX; ++chunk) {
+        const zero_run_chunk_t *const current = job.results + chunk;
+        const size_t start = hint + (chunk * job.per_chunk);
+        if (start >= bitmap->bit_count) {
+            break;
+        }
+        const size_t length = (bitmap->bit_count - start) > job.per_chunk ? job.per_chunk : bitmap->bit_count - start;
+        if (current->prefix) {
+            open_start = open_length ? open_start : start;
+            open_length += current->prefix;
+        }
+        // The open run either carries on through the whole chunk or it ends here
+        if (n_bits && open_length >= n_bits) {
+            result = open_start;
+            break;
+        } else if (!n_bits && open_length > longest) {
+            longest = open_length;
+            longest_start = open_start;
+        }
+        if (current->prefix != length) {
+            if (n_bits) {
+                result = current->best_start;
+            } else if (current->best_length > longest) {
+                longest = current->best_length;
+                longest_start = current->best_start;
+            }
+            open_start = start + length - current->suffix;
+            open_length = current->suffix;
+        }
+    }
+    if (n_bits) {
+        return result;
+    }
+    if (run_start) {
+        *run_start = longest_start;
+    }
+    return longest;
+}
+
+void bitmap_touch(bitmap_t *const bitmap, const size_t first, const size_t last) {
+    if (FLAG_CHECK(bitmap, SUMMARY)) {
+        bitmap_summary_rebuild(bitmap, first, last);
+    }
+    if (FLAG_CHECK(bitmap, RANKED) && (first >> RANK_SUPERBLOCK_SHIFT) < bitmap->rank->stale_from) {
+        bitmap->rank->stale_from = first >> RANK_SUPERBLOCK_SHIFT;
+    }
+}
+
+void bitmap_atomic_touch(bitmap_t *const bitmap, const size_t word) {
+    if (FLAG_CHECK(bitmap, SUMMARY)) {
+        // Somebody else can be changing this word (or another one under the same summary word) right now,
+        // and their summary update can land before or after ours. So after every update we look at
+        // the data again and go around if it moved. Whoever updates a summary bit last sees the final
+        // value of the word (every summary update is an acq_rel RMW on the same summary word, and every
+        // data write comes before its writer's summary update), so the last one always leaves it right.
+        const uint64_t bit = ((uint64_t) 1) << (word & WORD_MASK);
+        const uint64_t full = (word == bitmap->word_count - 1) ? word_tail_mask(bitmap) : ~((uint64_t) 0);
+        uint64_t *const has_set = bitmap->has_set + (word >> WORD_SHIFT);
+        uint64_t *const has_clear = bitmap->has_clear + (word >> WORD_SHIFT);
+        uint64_t value = atomic_word_load_masked(bitmap, word), check;
+        do {
+            if (value) {
+                __atomic_fetch_or(has_set, bit, __ATOMIC_ACQ_REL);
+            } else {
+                __atomic_fetch_and(has_set, ~bit, __ATOMIC_ACQ_REL);
+            }
+            if (value != full) {
+                __atomic_fetch_or(has_clear, bit, __ATOMIC_ACQ_REL);
+            } else {
+                __atomic_fetch_and(has_clear, ~bit, __ATOMIC_ACQ_REL);
+            }
+            check = value;
+        } while ((value = atomic_word_load_masked(bitmap, word)) != check);
+    }
+    if (FLAG_CHECK(bitmap, RANKED)) {
+        // Only ever moves down, and the counts only get redone under the caller's lock
+        const size_t superblock = word >> RANK_SUPERBLOCK_SHIFT;
+        size_t stale_from = __atomic_load_n(&bitmap->rank->stale_from, __ATOMIC_RELAXED);
+        while (superblock < stale_from &&
+               !__atomic_compare_exchange_n(&bitmap->rank->stale_from, &stale_from, superblock, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+void bitmap_rank_refresh(const bitmap_t *const bitmap) {
+    rank_index_t *const rank = bitmap->rank;
+    if (rank->stale_from != SIZE_MAX) {
+        // Everything from the first stale superblock on, since every count after it includes it
+        for (size_t superblock = rank->stale_from; superblock < rank->superblocks; ++superblock) {
+            size_t total = rank->counts[superblock];
+            const size_t first = superblock << RANK_SUPERBLOCK_SHIFT;
+            const size_t last = first + RANK_SUPERBLOCK_WORDS < bitmap->word_count ? first + RANK_SUPERBLOCK_WORDS : bitmap->word_count;
+            for (size_t word = first; word < last; ++word) {
+                total += __builtin_popcountll(word_load_masked(bitmap, word, 0));
+            }
+            rank->counts[superblock + 1] = total;
+        }
+        rank->stale_from = SIZE_MAX;
+    }
+}
+
+void bitmap_summary_rebuild(bitmap_t *const bitmap, const size_t first, const size_t last) {
+    // Could do 64 at a time, but this is only ever as much work as whatever wrote the data
+    for (size_t word = first; word <= last; ++word) {
+        summary_update(bitmap, word);
+    }
+}
+
+size_t bitmap_scan_backward(const bitmap_t *const bitmap, const size_t bit, const uint64_t invert) {
+    if (bitmap && bit) {
+        // Last candidate is the bit before the one given (or the last bit, if they gave us something huge)
+        // Since the candidate is always in range, masking down to it also clears the tail garbage
+        const size_t last = (bit > bitmap->bit_count ? bitmap->bit_count : bit) - 1;
+        size_t word = last >> WORD_SHIFT;
+        uint64_t value = (word_load(bitmap, word) ^ invert) & (~((uint64_t) 0) >> (WORD_MASK - (last & WORD_MASK)));
+        while (!value) {
+            if (!word) {
+                return SIZE_MAX;
+            }
+            value = word_load(bitmap, --word) ^ invert;
+        }
+        return (word << WORD_SHIFT) + (WORD_MASK - WORD_CLZ(value));
+    }
+    return SIZE_MAX;
+}
@@ -0,0 +1,807 @@
+#include "../include/cbitmap.h"
+
+// Chunk geometry. A chunk is 64K bits, addressed by the low 16 bits of the bit number
+#define CHUNK_SHIFT 16
+#define CHUNK_BITS (((size_t) 1) << CHUNK_SHIFT)
+#define CHUNK_MASK (CHUNK_BITS - 1)
+#define CHUNK_KEY(bit) ((bit) >> CHUNK_SHIFT)
+#define CHUNK_LOW(bit) ((uint16_t) ((bit) & CHUNK_MASK))
+
+// An array of more than 4096 uint16_t is bigger than the 8KB bitset
+#define ARRAY_MAX 4096
+#define BITSET_WORDS (CHUNK_BITS >> 6)
+#define BITSET_BYTES (BITSET_WORDS * sizeof(uint64_t))
+
+// Serialized format, everything little-endian:
+//  magic (4), bit count (8), container count (8)
+//  then per container: key (8), type (1), cardinality (4), size (4), and the payload
+//   array: size uint16_t values, bitset: 1024 uint64_t words, run: size (start, length - 1) uint16_t pairs
+#define SERIAL_MAGIC 0x314D4243 // "CBM1"
+#define SERIAL_HEADER_BYTES (4 + 8 + 8)
+#define SERIAL_CONTAINER_BYTES (8 + 1 + 4 + 4)
+
+typedef enum {ARRAY_CONTAINER = 0x01, BITSET_CONTAINER = 0x02, RUN_CONTAINER = 0x03} CONTAINER_TYPE;
+
+typedef struct {
+    size_t key; // Which chunk this is (bit >> 16)
+    CONTAINER_TYPE type;
+    uint32_t cardinality; // Bits set, never 0 (empty containers get removed)
+    // array: size values in use out of capacity
+    // run: size runs (so 2 * size values) in use, out of capacity runs
+    uint32_t size, capacity;
+    uint16_t *values; // array and run containers
+    uint64_t *words; // bitset containers
+} container_t;
+
+struct cbitmap {
+    size_t bit_count;
+    // Sorted by key, only chunks with bits set
+    size_t count, capacity;
+    container_t *containers;
+};
+
+// Boolean ops, same as the dense bitmap's
+typedef enum {OP_AND, OP_OR, OP_XOR, OP_ANDNOT} CBITMAP_OP;
+
+// Container helpers, see impl for details
+// (static, so they stay out of the shared library's symbols)
+static void container_free(container_t *const container);
+
+static bool container_test(const container_t *const container, const uint16_t low);
+
+static bool container_set(container_t *const container, const uint16_t low);
+
+static bool container_reset(container_t *const container, const uint16_t low);
+
+static void container_materialize(const container_t *const container, uint64_t *const words);
+
+static bool container_from_words(container_t *const container, const uint64_t *const words);
+
+// Looks for a chunk, returns where it is (or where it goes if it isn't there)
+size_t cbitmap_find(const cbitmap_t *const bitmap, const size_t key, bool *const found);
+
+// Makes an empty array container for key at index, NULL on error
+container_t *cbitmap_insert(cbitmap_t *const bitmap, const size_t index, const size_t key);
+
+// Frees the container at index and closes the gap
+void cbitmap_remove(cbitmap_t *const bitmap, const size_t index);
+
+// Core of and/or/xor/andnot
+bool cbitmap_combine(cbitmap_t *const bitmap, const cbitmap_t *const other, const CBITMAP_OP op);
+
+
+cbitmap_t *cbitmap_create(const size_t n_bits) {
+    if (n_bits) {
+        // Empty to start, containers show up as bits get set
+        cbitmap_t *bitmap = (cbitmap_t *) calloc(1, sizeof(cbitmap_t));
+        if (bitmap) {
+            bitmap->bit_count = n_bits;
+            return bitmap;
+        }
+    }
+    return NULL;
+}
+
+void cbitmap_destroy(cbitmap_t *bitmap) {
+    if (bitmap) {
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            container_free(&bitmap->containers[idx]);
+        }
+        free(bitmap->containers);
+        free(bitmap);
+    }
+}
+
+bool cbitmap_set(cbitmap_t *const bitmap, const size_t bit) {
+    if (bitmap && bit < bitmap->bit_count) {
+        bool found;
+        const size_t index = cbitmap_find(bitmap, CHUNK_KEY(bit), &found);
+        container_t *const container = found ? &bitmap->containers[index] : cbitmap_insert(bitmap, index, CHUNK_KEY(bit));
+        if (container) {
+            if (container_set(container, CHUNK_LOW(bit))) {
+                return true;
+            }
+            if (!found) {
+                // Don't leave an empty container behind
+                cbitmap_remove(bitmap, index);
+            }
+        }
+    }
+    return false;
+}
+
+bool cbitmap_reset(cbitmap_t *const bitmap, const size_t bit) {
+    if (bitmap && bit < bitmap->bit_count) {
+        bool found;
+        const size_t index = cbitmap_find(bitmap, CHUNK_KEY(bit), &found);
+        if (!found) {
+            // Already clear
+            return true;
+        }
+        if (container_reset(&bitmap->containers[index], CHUNK_LOW(bit))) {
+            if (!bitmap->containers[index].cardinality) {
+                cbitmap_remove(bitmap, index);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool cbitmap_test(const cbitmap_t *const bitmap, const size_t bit) {
+    if (bitmap && bit < bitmap->bit_count) {
+        bool found;
+        const size_t index = cbitmap_find(bitmap, CHUNK_KEY(bit), &found);
+        return found && container_test(&bitmap->containers[index], CHUNK_LOW(bit));
+    }
+    return false;
+}
+
+size_t cbitmap_ffs(const cbitmap_t *const bitmap) {
+    if (bitmap && bitmap->count) {
+        // Containers are never empty, so the first one has the answer
+        const container_t *const container = &bitmap->containers[0];
+        size_t low = 0;
+        if (container->type == BITSET_CONTAINER) {
+            size_t word = 0;
+            while (!container->words[word]) {
+                ++word;
+            }
+            low = (word << 6) + __builtin_ctzll(container->words[word]);
+        } else {
+            // Lowest value and lowest run start are both the first value
+            low = container->values[0];
+        }
+        return (container->key << CHUNK_SHIFT) + low;
+    }
+    return SIZE_MAX;
+}
+
+size_t cbitmap_ffz(const cbitmap_t *const bitmap) {
+    if (bitmap) {
+        // Walk the chunks in order until one is missing (all clear) or isn't full
+        size_t key = 0;
+        for (size_t idx = 0; idx < bitmap->count && bitmap->containers[idx].key == key; ++idx, ++key) {
+            const container_t *const container = &bitmap->containers[idx];
+            size_t low = CHUNK_BITS;
+            if (container->cardinality == CHUNK_BITS) {
+                continue;
+            }
+            switch (container->type) {
+                case ARRAY_CONTAINER:
+                    // Sorted and unique, so the first gap is the first value out of place
+                    for (low = 0; low < container->size && container->values[low] == low; ++low) {}
+                    break;
+                case BITSET_CONTAINER:
+                    for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                        if (~container->words[word]) {
+                            low = (word << 6) + __builtin_ctzll(~container->words[word]);
+                            break;
+                        }
+                    }
+                    break;
+                default:
+                    // Either the first run doesn't start at 0, or the zero is right after it
+                    low = container->values[0] ? 0 : ((size_t) container->values[1]) + 1;
+            }
+            const size_t result = (key << CHUNK_SHIFT) + low;
+            return result < bitmap->bit_count ? result : SIZE_MAX;
+        }
+        const size_t result = key << CHUNK_SHIFT;
+        return result < bitmap->bit_count ? result : SIZE_MAX;
+    }
+    return SIZE_MAX;
+}
+
+size_t cbitmap_total_set(const cbitmap_t *const bitmap) {
+    size_t total = 0;
+    if (bitmap) {
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            total += bitmap->containers[idx].cardinality;
+        }
+    }
+    return total;
+}
+
+size_t cbitmap_get_bits(const cbitmap_t *const bitmap) {
+    return bitmap ? bitmap->bit_count : 0;
+}
+
+void cbitmap_for_each(const cbitmap_t *const bitmap, void (*func)(size_t, void *), void *args) {
+    if (bitmap && func) {
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            const container_t *const container = &bitmap->containers[idx];
+            const size_t base = container->key << CHUNK_SHIFT;
+            switch (container->type) {
+                case ARRAY_CONTAINER:
+                    for (size_t value = 0; value < container->size; ++value) {
+                        func(base + container->values[value], args);
+                    }
+                    break;
+                case BITSET_CONTAINER:
+                    for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                        for (uint64_t value = container->words[word]; value; value &= value - 1) {
+                            func(base + (word << 6) + __builtin_ctzll(value), args);
+                        }
+                    }
+                    break;
+                default:
+                    for (size_t run = 0; run < container->size; ++run) {
+                        const size_t start = base + container->values[run << 1];
+                        const size_t end = start + container->values[(run << 1) + 1];
+                        for (size_t bit = start; bit <= end; ++bit) {
+                            func(bit, args);
+                        }
+                    }
+            }
+        }
+    }
+}
+
+bool cbitmap_and(cbitmap_t *const bitmap, const cbitmap_t *const other) {
+    return cbitmap_combine(bitmap, other, OP_AND);
+}
+
+bool cbitmap_or(cbitmap_t *const bitmap, const cbitmap_t *const other) {
+    return cbitmap_combine(bitmap, other, OP_OR);
+}
+
+bool cbitmap_xor(cbitmap_t *const bitmap, const cbitmap_t *const other) {
+    return cbitmap_combine(bitmap, other, OP_XOR);
+}
+
+bool cbitmap_andnot(cbitmap_t *const bitmap, const cbitmap_t *const other) {
+    return cbitmap_combine(bitmap, other, OP_ANDNOT);
+}
+
+bool cbitmap_optimize(cbitmap_t *const bitmap) {
+    if (bitmap) {
+        uint64_t words[BITSET_WORDS];
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            container_t *const container = &bitmap->containers[idx];
+            container_materialize(container, words);
+            // A run starts at every set bit whose lower neighbour is clear
+            size_t runs = 0;
+            for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                const uint64_t carry = word ? (words[word - 1] >> 63) : 0;
+                runs += __builtin_popcountll(words[word] & ~((words[word] << 1) | carry));
+            }
+            // Sizes in bytes: runs are 4 each, array values 2 each, bitset is fixed
+            const size_t run_bytes = runs * 4;
+            const size_t other_bytes = container->cardinality <= ARRAY_MAX ? container->cardinality * 2 : BITSET_BYTES;
+            if (run_bytes < other_bytes) {
+                if (container->type != RUN_CONTAINER) {
+                    uint16_t *const values = (uint16_t *) malloc(run_bytes);
+                    if (!values) {
+                        return false;
+                    }
+                    size_t run = 0;
+                    for (size_t bit = 0; bit < CHUNK_BITS; ++bit) {
+                        if (words[bit >> 6] & (((uint64_t) 1) << (bit & 63))) {
+                            const size_t start = bit;
+                            while (bit + 1 < CHUNK_BITS && (words[(bit + 1) >> 6] & (((uint64_t) 1) << ((bit + 1) & 63)))) {
+                                ++bit;
+                            }
+                            values[run << 1] = (uint16_t) start;
+                            values[(run << 1) + 1] = (uint16_t) (bit - start);
+                            ++run;
+                        }
+                    }
+                    const uint32_t cardinality = container->cardinality;
+                    container_free(container);
+                    container->type = RUN_CONTAINER;
+                    container->cardinality = cardinality;
+                    container->size = container->capacity = runs;
+                    container->values = values;
+                }
+            } else if (container->type == RUN_CONTAINER) {
+                if (!container_from_words(container, words)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Little-endian field writers/readers for serialization, the position moves past the field
+static void serial_put(uint8_t **const position, uint64_t value, const size_t bytes) {
+    for (size_t byte = 0; byte < bytes; ++byte, value >>= 8) {
+        *((*position)++) = (uint8_t) value;
+    }
+}
+
+static uint64_t serial_get(const uint8_t **const position, const size_t bytes) {
+    uint64_t value = 0;
+    for (size_t byte = 0; byte < bytes; ++byte) {
+        value |= ((uint64_t) *((*position)++)) << (byte << 3);
+    }
+    return value;
+}
+
+size_t cbitmap_serialized_size(const cbitmap_t *const bitmap) {
+    if (bitmap) {
+        size_t total = SERIAL_HEADER_BYTES;
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            const container_t *const container = &bitmap->containers[idx];
+            total += SERIAL_CONTAINER_BYTES;
+            switch (container->type) {
+                case ARRAY_CONTAINER:
+                    total += container->size * 2;
+                    break;
+                case BITSET_CONTAINER:
+                    total += BITSET_BYTES;
+                    break;
+                default:
+                    total += container->size * 4;
+            }
+        }
+        return total;
+    }
+    return 0;
+}
+
+size_t cbitmap_serialize(const cbitmap_t *const bitmap, void *const buffer, const size_t size) {
+    const size_t needed = cbitmap_serialized_size(bitmap);
+    if (needed && buffer && size >= needed) {
+        uint8_t *position = (uint8_t *) buffer;
+        serial_put(&position, SERIAL_MAGIC, 4);
+        serial_put(&position, bitmap->bit_count, 8);
+        serial_put(&position, bitmap->count, 8);
+        for (size_t idx = 0; idx < bitmap->count; ++idx) {
+            const container_t *const container = &bitmap->containers[idx];
+            serial_put(&position, container->key, 8);
+            serial_put(&position, container->type, 1);
+            serial_put(&position, container->cardinality, 4);
+            serial_put(&position, container->size, 4);
+            if (container->type == BITSET_CONTAINER) {
+                for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                    serial_put(&position, container->words[word], 8);
+                }
+            } else {
+                const size_t values = container->type == ARRAY_CONTAINER ? container->size : container->size * 2;
+                for (size_t value = 0; value < values; ++value) {
+                    serial_put(&position, container->values[value], 2);
+                }
+            }
+        }
+        return needed;
+    }
+    return 0;
+}
+
+cbitmap_t *cbitmap_deserialize(const void *const buffer, const size_t size) {
+    if (!buffer || size < SERIAL_HEADER_BYTES) {
+        return NULL;
+    }
+    const uint8_t *position = (const uint8_t *) buffer;
+    const uint8_t *const end = position + size;
+    if (serial_get(&position, 4) != SERIAL_MAGIC) {
+        return NULL;
+    }
+    const size_t bit_count = serial_get(&position, 8);
+    const size_t count = serial_get(&position, 8);
+    // Can't have more containers than chunks, or than could fit in what's left
+    if (count > CHUNK_KEY(bit_count - 1) + 1 || count > (size_t) (end - position) / SERIAL_CONTAINER_BYTES) {
+        return NULL;
+    }
+    cbitmap_t *bitmap = cbitmap_create(bit_count);
+    if (!bitmap) {
+        return NULL;
+    }
+    if (count && !(bitmap->containers = (container_t *) calloc(count, sizeof(container_t)))) {
+        cbitmap_destroy(bitmap);
+        return NULL;
+    }
+    bitmap->capacity = count;
+
+    // Everything gets checked, a bad buffer shouldn't be able to build a bitmap that breaks the rules
+    uint64_t words[BITSET_WORDS];
+    for (size_t idx = 0; idx < count; ++idx) {
+        if ((size_t) (end - position) < SERIAL_CONTAINER_BYTES) {
+            break;
+        }
+        container_t *const container = &bitmap->containers[idx];
+        container->key = serial_get(&position, 8);
+        container->type = (CONTAINER_TYPE) serial_get(&position, 1);
+        container->cardinality = serial_get(&position, 4);
+        container->size = container->capacity = serial_get(&position, 4);
+        bitmap->count = idx + 1; // so destroy cleans this one up if it turns out bad
+
+        if ((idx && container->key <= bitmap->containers[idx - 1].key) || container->key > CHUNK_KEY(bit_count - 1)) {
+            break;
+        }
+        size_t payload;
+        switch (container->type) {
+            case ARRAY_CONTAINER:
+                payload = container->size * 2;
+                break;
+            case BITSET_CONTAINER:
+                payload = BITSET_BYTES;
+                break;
+            case RUN_CONTAINER:
+                payload = container->size * 4;
+                break;
+            default:
+                payload = SIZE_MAX;
+        }
+        if (payload > (size_t) (end - position) || (!container->size && container->type != BITSET_CONTAINER)) {
+            break;
+        }
+        // Read it into a bitset, checking ordering as we go, then rebuild the container from that
+        memset(words, 0x00, BITSET_BYTES);
+        bool valid = true;
+        if (container->type == BITSET_CONTAINER) {
+            for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                words[word] = serial_get(&position, 8);
+            }
+        } else {
+            const bool runs = container->type == RUN_CONTAINER;
+            size_t next = 0; // lowest value allowed next
+            for (size_t entry = 0; entry < container->size; ++entry) {
+                const size_t start = serial_get(&position, 2);
+                const size_t last = runs ? start + serial_get(&position, 2) : start;
+                valid = valid && start >= next && last < CHUNK_BITS;
+                for (size_t bit = start; valid && bit <= last; ++bit) {
+                    words[bit >> 6] |= ((uint64_t) 1) << (bit & 63);
+                }
+                next = last + (runs ? 2 : 1); // runs that touch should have been one run
+            }
+        }
+        size_t cardinality = 0, highest = 0;
+        for (size_t word = 0; word < BITSET_WORDS; ++word) {
+            cardinality += __builtin_popcountll(words[word]);
+            highest = words[word] ? (word << 6) + 63 - __builtin_clzll(words[word]) : highest;
+        }
+        if (!valid || !cardinality || cardinality != container->cardinality ||
+                (container->key << CHUNK_SHIFT) + highest >= bit_count ||
+                (container->type == ARRAY_CONTAINER && cardinality > ARRAY_MAX)) {
+            break;
+        }
+        // Runs stay runs, the rest get rebuilt as whatever their cardinality calls for
+        if (container->type == RUN_CONTAINER) {
+            container->values = (uint16_t *) malloc(payload);
+            if (!container->values) {
+                break;
+            }
+            position -= payload;
+            for (size_t value = 0; value < container->size * 2; ++value) {
+                container->values[value] = serial_get(&position, 2);
+            }
+        } else {
+            container->type = ARRAY_CONTAINER;
+            container->size = container->capacity = 0;
+            if (!container_from_words(container, words)) {
+                break;
+            }
+        }
+        if (idx + 1 == count && position == end) {
+            return bitmap;
+        }
+    }
+    if (!count && position == end) {
+        return bitmap;
+    }
+    cbitmap_destroy(bitmap);
+    return NULL;
+}
+
+//
+///
+// HERE BE DRAGONS
+///
+//
+
+static void container_free(container_t *const container) {
+    free(container->values);
+    free(container->words);
+    container->values = NULL;
+    container->words = NULL;
+    container->size = container->capacity = container->cardinality = 0;
+}
+
+// First index in values[0, size) that is >= low
+static size_t values_lower_bound(const uint16_t *const values, size_t size, const uint16_t low) {
+    size_t first = 0;
+    while (size) {
+        const size_t half = size >> 1;
+        if (values[first + half] < low) {
+            first += half + 1;
+            size -= half + 1;
+        } else {
+            size = half;
+        }
+    }
+    return first;
+}
+
+// Index of the run that would contain low (the last run starting at or before it), size if none
+static size_t runs_find(const container_t *const container, const uint16_t low) {
+    size_t first = 0, size = container->size;
+    while (size) {
+        const size_t half = size >> 1;
+        if (container->values[(first + half) << 1] <= low) {
+            first += half + 1;
+            size -= half + 1;
+        } else {
+            size = half;
+        }
+    }
+    return first ? first - 1 : container->size;
+}
+
+static bool container_test(const container_t *const container, const uint16_t low) {
+    switch (container->type) {
+        case ARRAY_CONTAINER: {
+            const size_t index = values_lower_bound(container->values, container->size, low);
+            return index < container->size && container->values[index] == low;
+        }
+        case BITSET_CONTAINER:
+            return container->words[low >> 6] & (((uint64_t) 1) << (low & 63));
+        default: {
+            const size_t run = runs_find(container, low);
+            return run < container->size &&
+                   (size_t) low <= (size_t) container->values[run << 1] + container->values[(run << 1) + 1];
+        }
+    }
+}
+
+static bool container_set(container_t *const container, const uint16_t low) {
+    if (container_test(container, low)) {
+        return true;
+    }
+    if (container->type == RUN_CONTAINER) {
+        // Runs are only built by optimize, anything that edits one turns it back into array/bitset
+        uint64_t words[BITSET_WORDS];
+        container_materialize(container, words);
+        words[low >> 6] |= ((uint64_t) 1) << (low & 63);
+        return container_from_words(container, words);
+    }
+    if (container->type == ARRAY_CONTAINER && container->cardinality == ARRAY_MAX) {
+        // Full array, time to be a bitset
+        uint64_t *const words = (uint64_t *) calloc(BITSET_WORDS, sizeof(uint64_t));
+        if (!words) {
+            return false;
+        }
+        container_materialize(container, words);
+        const uint32_t cardinality = container->cardinality;
+        container_free(container);
+        container->type = BITSET_CONTAINER;
+        container->words = words;
+        container->cardinality = cardinality;
+    }
+    if (container->type == BITSET_CONTAINER) {
+        container->words[low >> 6] |= ((uint64_t) 1) << (low & 63);
+        ++container->cardinality;
+        return true;
+    }
+    if (container->size == container->capacity) {
+        // Double it, like dyn_array
+        const uint32_t capacity = container->capacity ? container->capacity << 1 : 4;
+        uint16_t *const values = (uint16_t *) realloc(container->values, capacity * sizeof(uint16_t));
+        if (!values) {
+            return false;
+        }
+        container->values = values;
+        container->capacity = capacity;
+    }
+    const size_t index = values_lower_bound(container->values, container->size, low);
+    memmove(container->values + index + 1, container->values + index, (container->size - index) * sizeof(uint16_t));
+    container->values[index] = low;
+    ++container->size;
+    ++container->cardinality;
+    return true;
+}
+
+static bool container_reset(container_t *const container, const uint16_t low) {
+    if (!container_test(container, low)) {
+        return true;
+    }
+    switch (container->type) {
+        case ARRAY_CONTAINER: {
+            const size_t index = values_lower_bound(container->values, container->size, low);
+            memmove(container->values + index, container->values + index + 1, (container->size - index - 1) * sizeof(uint16_t));
+            --container->size;
+            --container->cardinality;
+            return true;
+        }
+        case BITSET_CONTAINER:
+            container->words[low >> 6] &= ~(((uint64_t) 1) << (low & 63));
+            if (--container->cardinality > ARRAY_MAX) {
+                return true;
+            }
+            // Small enough to be an array again (from_words won't touch words until it has the array)
+            // If that fails, we're still a perfectly good bitset
+            container_from_words(container, container->words);
+            return true;
+        default: {
+            uint64_t words[BITSET_WORDS];
+            container_materialize(container, words);
+            words[low >> 6] &= ~(((uint64_t) 1) << (low & 63));
+            if (container->cardinality == 1) {
+                // That was the last one, the caller removes us
+                container_free(container);
+                return true;
+            }
+            return container_from_words(container, words);
+        }
+    }
+}
+
+static void container_materialize(const container_t *const container, uint64_t *const words) {
+    if (container->type == BITSET_CONTAINER) {
+        if (words != container->words) {
+            memcpy(words, container->words, BITSET_BYTES);
+        }
+        return;
+    }
+    memset(words, 0x00, BITSET_BYTES);
+    if (container->type == ARRAY_CONTAINER) {
+        for (size_t value = 0; value < container->size; ++value) {
+            words[container->values[value] >> 6] |= ((uint64_t) 1) << (container->values[value] & 63);
+        }
+    } else {
+        for (size_t run = 0; run < container->size; ++run) {
+            const size_t start = container->values[run << 1];
+            const size_t end = start + container->values[(run << 1) + 1];
+            for (size_t bit = start; bit <= end; ++bit) {
+                words[bit >> 6] |= ((uint64_t) 1) << (bit & 63);
+            }
+        }
+    }
+}
+
+static bool container_from_words(container_t *const container, const uint64_t *const words) {
+    // Becomes an array or a bitset depending on how many bits there are
+    // Nothing about the container changes until the new storage is in hand
+    size_t cardinality = 0;
+    for (size_t word = 0; word < BITSET_WORDS; ++word) {
+        cardinality += __builtin_popcountll(words[word]);
+    }
+    if (cardinality <= ARRAY_MAX) {
+        uint16_t *const values = (uint16_t *) malloc((cardinality ? cardinality : 1) * sizeof(uint16_t));
+        if (!values) {
+            return false;
+        }
+        size_t count = 0;
+        for (size_t word = 0; word < BITSET_WORDS; ++word) {
+            for (uint64_t value = words[word]; value; value &= value - 1) {
+                values[count++] = (uint16_t) ((word << 6) + __builtin_ctzll(value));
+            }
+        }
+        container_free(container);
+        container->type = ARRAY_CONTAINER;
+        container->values = values;
+        container->size = container->capacity = cardinality;
+    } else if (words != container->words) {
+        uint64_t *const copy = (uint64_t *) malloc(BITSET_BYTES);
+        if (!copy) {
+            return false;
+        }
+        memcpy(copy, words, BITSET_BYTES);
+        container_free(container);
+        container->type = BITSET_CONTAINER;
+        container->words = copy;
+    }
+    container->cardinality = cardinality;
+    return true;
+}
+
+size_t cbitmap_find(const cbitmap_t *const bitmap, const size_t key, bool *const found) {
+    size_t first = 0, size = bitmap->count;
+    while (size) {
+        const size_t half = size >> 1;
+        if (bitmap->containers[first + half].key < key) {
+            first += half + 1;
+            size -= half + 1;
+        } else {
+            size = half;
+        }
+    }
+    *found = first < bitmap->count && bitmap->containers[first].key == key;
+    return first;
+}
+
+container_t *cbitmap_insert(cbitmap_t *const bitmap, const size_t index, const size_t key) {
+    if (bitmap->count == bitmap->capacity) {
+        const size_t capacity = bitmap->capacity ? bitmap->capacity << 1 : 4;
+        container_t *const containers = (container_t *) realloc(bitmap->containers, capacity * sizeof(container_t));
+        if (!containers) {
+            return NULL;
+        }
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+    memmove(bitmap->containers + index + 1, bitmap->containers + index, (bitmap->count - index) * sizeof(container_t));
+    ++bitmap->count;
+    container_t *const container = &bitmap->containers[index];
+    memset(container, 0x00, sizeof(container_t));
+    container->key = key;
+    container->type = ARRAY_CONTAINER;
+    return container;
+}
+
+void cbitmap_remove(cbitmap_t *const bitmap, const size_t index) {
+    container_free(&bitmap->containers[index]);
+    memmove(bitmap->containers + index, bitmap->containers + index + 1, (bitmap->count - index - 1) * sizeof(container_t));
+    --bitmap->count;
+}
+
+bool cbitmap_combine(cbitmap_t *const bitmap, const cbitmap_t *const other, const CBITMAP_OP op) {
+    if (!bitmap || !other || bitmap->bit_count != other->bit_count) {
+        return false;
+    }
+    // Merge the two sorted chunk lists into a new one
+    //  only in bitmap: kept unless it's AND
+    //  only in other: copied in for OR/XOR
+    //  in both: combined as bitsets, then stored as whatever fits
+    // Containers from bitmap are moved, so if something fails the rest just get moved over untouched
+    const size_t capacity = bitmap->count + ((op == OP_OR || op == OP_XOR) ? other->count : 0);
+    container_t *const result = (container_t *) malloc((capacity ? capacity : 1) * sizeof(container_t));
+    if (!result) {
+        return false;
+    }
+    bool success = true;
+    size_t count = 0, mine = 0, theirs = 0;
+    uint64_t words[BITSET_WORDS], other_words[BITSET_WORDS];
+    while (mine < bitmap->count || theirs < other->count) {
+        container_t *const container = mine < bitmap->count ? &bitmap->containers[mine] : NULL;
+        const container_t *const other_container = theirs < other->count ? &other->containers[theirs] : NULL;
+        if (container && (!other_container || container->key < other_container->key)) {
+            if (op == OP_AND && success) {
+                container_free(container);
+            } else {
+                result[count++] = *container;
+            }
+            ++mine;
+        } else if (other_container && (!container || other_container->key < container->key)) {
+            if (success && (op == OP_OR || op == OP_XOR)) {
+                container_t *const copy = &result[count];
+                memset(copy, 0x00, sizeof(container_t));
+                copy->key = other_container->key;
+                copy->type = ARRAY_CONTAINER;
+                container_materialize(other_container, other_words);
+                if (container_from_words(copy, other_words)) {
+                    ++count;
+                } else {
+                    success = false;
+                }
+            }
+            ++theirs;
+        } else {
+            if (success) {
+                container_materialize(container, words);
+                container_materialize(other_container, other_words);
+                for (size_t word = 0; word < BITSET_WORDS; ++word) {
+                    switch (op) {
+                        case OP_AND:
+                            words[word] &= other_words[word];
+                            break;
+                        case OP_OR:
+                            words[word] |= other_words[word];
+                            break;
+                        case OP_XOR:
+                            words[word] ^= other_words[word];
+                            break;
+                        default:
+                            words[word] &= ~other_words[word];
+                    }
+                }
+                success = container_from_words(container, words);
+            }
+            if (container->cardinality) {
+                result[count++] = *container;
+            } else {
+                container_free(container);
+            }
+            ++mine;
+            ++theirs;
+        }
+    }
+    free(bitmap->containers);
+    bitmap->containers = result;
+    bitmap->count = count;
+    bitmap->capacity = capacity ? capacity : 1;
+    return success;
+}
@@ -0,0 +1,345 @@
+#include "../include/cbitmap.h"
+#include "../src/cbitmap.c"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+    cbitmap_t *cbitmap_create(const size_t n_bits);
+    1. Normal
+    2. Fail, zero bits
+
+    bool cbitmap_set(cbitmap_t *const bitmap, const size_t bit);
+    bool cbitmap_reset(cbitmap_t *const bitmap, const size_t bit);
+    bool cbitmap_test(const cbitmap_t *const bitmap, const size_t bit);
+    3. Normal, first/last bit, several chunks, chunks come and go
+    4. Normal, array grows into a bitset and shrinks back
+    5. Fail, out of range, NULL
+
+    size_t cbitmap_ffs(const cbitmap_t *const bitmap);
+    size_t cbitmap_ffz(const cbitmap_t *const bitmap);
+    size_t cbitmap_total_set(const cbitmap_t *const bitmap);
+    6. Normal, empty, full chunks, full bitmap, every container type
+    7. Fail, NULL
+
+    void cbitmap_for_each(const cbitmap_t *const bitmap, void (*func)(size_t, void *), void *args);
+    8. Normal, in order, every container type
+
+    bool cbitmap_optimize(cbitmap_t *const bitmap);
+    9. Normal, long stretches become runs, runs still answer everything, editing a run
+
+    bool cbitmap_and/or/xor/andnot(cbitmap_t *const bitmap, const cbitmap_t *const other);
+    10. Normal, every op matches a bit-by-bit version, chunks only on one side, results that empty a chunk
+    11. Fail, size mismatch, NULL
+
+    size_t cbitmap_serialized_size(const cbitmap_t *const bitmap);
+    size_t cbitmap_serialize(const cbitmap_t *const bitmap, void *const buffer, const size_t size);
+    cbitmap_t *cbitmap_deserialize(const void *const buffer, const size_t size);
+    12. Normal, round trip with every container type, empty bitmap
+    13. Fail, buffer too small, truncated, bad magic, out of order, bits past the end, NULL
+*/
+
+// Big enough for 4 chunks, and not a multiple of the chunk size
+#define TEST_BITS (3 * 65536 + 1000)
+
+size_t for_each_previous, for_each_count;
+bool for_each_ordered;
+
+void for_each_check(size_t bit_num, void *value) {
+    for_each_ordered = for_each_ordered && (!for_each_count || bit_num > for_each_previous);
+    for_each_ordered = for_each_ordered && cbitmap_test((const cbitmap_t *) value, bit_num);
+    for_each_previous = bit_num;
+    ++for_each_count;
+}
+
+bool for_each_matches(const cbitmap_t *const bitmap) {
+    for_each_previous = for_each_count = 0;
+    for_each_ordered = true;
+    cbitmap_for_each(bitmap, &for_each_check, (void *) bitmap);
+    return for_each_ordered && for_each_count == cbitmap_total_set(bitmap);
+}
+
+// Checks a cbitmap against a plain bool array, bit for bit
+bool cbitmap_matches(const cbitmap_t *const bitmap, const bool *const reference) {
+    size_t total = 0, first_set = SIZE_MAX, first_zero = SIZE_MAX;
+    for (size_t bit = 0; bit < TEST_BITS; ++bit) {
+        if (cbitmap_test(bitmap, bit) != reference[bit]) {
+            return false;
+        }
+        total += reference[bit];
+        first_set = (first_set == SIZE_MAX && reference[bit]) ? bit : first_set;
+        first_zero = (first_zero == SIZE_MAX && !reference[bit]) ? bit : first_zero;
+    }
+    return cbitmap_total_set(bitmap) == total && cbitmap_ffs(bitmap) == first_set &&
+           cbitmap_ffz(bitmap) == first_zero && for_each_matches(bitmap);
+}
+
+void cbitmap_test_a();
+
+void cbitmap_test_b();
+
+void cbitmap_test_c();
+
+int main() {
+
+    // BASICS
+    cbitmap_test_a();
+
+    // OPTIMIZE AND BOOLEAN OPS
+    cbitmap_test_b();
+
+    // SERIALIZATION
+    cbitmap_test_c();
+
+    puts("TESTS PASSED");
+}
+
+void cbitmap_test_a() {
+    static bool reference[TEST_BITS];
+
+    // 1
+    cbitmap_t *bitmap_a = cbitmap_create(TEST_BITS);
+    assert(bitmap_a);
+    assert(cbitmap_get_bits(bitmap_a) == TEST_BITS);
+    assert(cbitmap_matches(bitmap_a, reference));
+
+    // 2
+    assert(cbitmap_create(0) == NULL);
+
+    // 3
+    const size_t bits[] = {0, 1, 65535, 65536, 100000, 3 * 65536, TEST_BITS - 1};
+    for (size_t idx = 0; idx < sizeof(bits) / sizeof(bits[0]); ++idx) {
+        assert(cbitmap_set(bitmap_a, bits[idx]));
+        reference[bits[idx]] = true;
+    }
+    assert(cbitmap_set(bitmap_a, 65536));
+    assert(bitmap_a->count == 3);
+    assert(cbitmap_matches(bitmap_a, reference));
+    assert(cbitmap_reset(bitmap_a, 100000));
+    reference[100000] = false;
+    assert(cbitmap_reset(bitmap_a, 65536));
+    reference[65536] = false;
+    assert(cbitmap_reset(bitmap_a, 65536));
+    assert(cbitmap_reset(bitmap_a, 2 * 65536));
+    assert(bitmap_a->count == 2);
+    assert(cbitmap_matches(bitmap_a, reference));
+
+    // 4
+    for (size_t bit = 65536; bit < 65536 + 5000; ++bit) {
+        assert(cbitmap_set(bitmap_a, bit));
+        reference[bit] = true;
+    }
+    assert(bitmap_a->count == 3);
+    assert(bitmap_a->containers[1].type == BITSET_CONTAINER);
+    assert(cbitmap_matches(bitmap_a, reference));
+    for (size_t bit = 65536; bit < 65536 + 1000; ++bit) {
+        assert(cbitmap_reset(bitmap_a, bit));
+        reference[bit] = false;
+    }
+    assert(bitmap_a->containers[1].type == ARRAY_CONTAINER);
+    assert(cbitmap_matches(bitmap_a, reference));
+
+    // 5
+    assert(cbitmap_set(bitmap_a, TEST_BITS) == false);
+    assert(cbitmap_reset(bitmap_a, TEST_BITS) == false);
+    assert(cbitmap_test(bitmap_a, TEST_BITS) == false);
+    assert(cbitmap_set(NULL, 0) == false);
+    assert(cbitmap_reset(NULL, 0) == false);
+    assert(cbitmap_test(NULL, 0) == false);
+    cbitmap_destroy(bitmap_a);
+
+    // 6
+    memset(reference, 0x00, sizeof(reference));
+    bitmap_a = cbitmap_create(TEST_BITS);
+    assert(bitmap_a);
+    assert(cbitmap_ffs(bitmap_a) == SIZE_MAX);
+    assert(cbitmap_ffz(bitmap_a) == 0);
+    for (size_t bit = 0; bit < 2 * 65536 + 10; ++bit) {
+        assert(cbitmap_set(bitmap_a, bit));
+        reference[bit] = true;
+    }
+    assert(cbitmap_ffz(bitmap_a) == 2 * 65536 + 10);
+    assert(cbitmap_matches(bitmap_a, reference));
+    assert(cbitmap_reset(bitmap_a, 2 * 65536 + 5));
+    reference[2 * 65536 + 5] = false;
+    assert(cbitmap_ffz(bitmap_a) == 2 * 65536 + 5);
+    assert(cbitmap_optimize(bitmap_a));
+    assert(bitmap_a->containers[0].type == RUN_CONTAINER);
+    assert(cbitmap_ffz(bitmap_a) == 2 * 65536 + 5);
+    assert(cbitmap_matches(bitmap_a, reference));
+    for (size_t bit = 2 * 65536 + 5; bit < TEST_BITS; ++bit) {
+        assert(cbitmap_set(bitmap_a, bit));
+        reference[bit] = true;
+    }
+    assert(cbitmap_ffz(bitmap_a) == SIZE_MAX);
+    assert(cbitmap_total_set(bitmap_a) == TEST_BITS);
+    cbitmap_destroy(bitmap_a);
+
+    // 7
+    assert(cbitmap_ffs(NULL) == SIZE_MAX);
+    assert(cbitmap_ffz(NULL) == SIZE_MAX);
+    assert(cbitmap_total_set(NULL) == 0);
+    assert(cbitmap_get_bits(NULL) == 0);
+}
+
+// Fills a cbitmap and its reference with one chunk of each kind, plus some noise
+void cbitmap_fill(cbitmap_t *const bitmap, bool *const reference, const size_t seed) {
+    srand(seed);
+    for (size_t idx = 0; idx < 300; ++idx) {
+        const size_t bit = rand() % 65536;
+        assert(cbitmap_set(bitmap, bit));
+        reference[bit] = true;
+    }
+    for (size_t idx = 0; idx < 20000; ++idx) {
+        const size_t bit = 65536 + (rand() % 65536);
+        assert(cbitmap_set(bitmap, bit));
+        reference[bit] = true;
+    }
+    const size_t run_start = 2 * 65536 + (rand() % 1000);
+    for (size_t bit = run_start; bit < run_start + 30000; ++bit) {
+        assert(cbitmap_set(bitmap, bit));
+        reference[bit] = true;
+    }
+}
+
+void cbitmap_test_b() {
+    static bool reference_a[TEST_BITS], reference_b[TEST_BITS], expected[TEST_BITS];
+    cbitmap_t *bitmap_a = cbitmap_create(TEST_BITS);
+    cbitmap_t *bitmap_b = cbitmap_create(TEST_BITS);
+    assert(bitmap_a && bitmap_b);
+
+    // 8
+    cbitmap_fill(bitmap_a, reference_a, 1);
+    assert(cbitmap_matches(bitmap_a, reference_a));
+
+    // 9
+    const size_t before = cbitmap_serialized_size(bitmap_a);
+    assert(cbitmap_optimize(bitmap_a));
+    assert(bitmap_a->containers[0].type == ARRAY_CONTAINER);
+    assert(bitmap_a->containers[1].type == BITSET_CONTAINER);
+    assert(bitmap_a->containers[2].type == RUN_CONTAINER);
+    assert(cbitmap_serialized_size(bitmap_a) < before);
+    assert(cbitmap_matches(bitmap_a, reference_a));
+    const size_t run_bit = bitmap_a->containers[2].values[0] + 2 * 65536 + 10;
+    assert(cbitmap_reset(bitmap_a, run_bit));
+    reference_a[run_bit] = false;
+    assert(cbitmap_matches(bitmap_a, reference_a));
+    assert(cbitmap_optimize(bitmap_a));
+    assert(bitmap_a->containers[2].type == RUN_CONTAINER);
+    assert(bitmap_a->containers[2].size == 2);
+    assert(cbitmap_matches(bitmap_a, reference_a));
+    assert(cbitmap_optimize(NULL) == false);
+
+    // 10
+    bool (*const ops[4])(cbitmap_t *const, const cbitmap_t *const) = {cbitmap_and, cbitmap_or, cbitmap_xor, cbitmap_andnot};
+    cbitmap_fill(bitmap_b, reference_b, 2);
+    assert(cbitmap_set(bitmap_b, TEST_BITS - 1));
+    reference_b[TEST_BITS - 1] = true;
+    assert(cbitmap_optimize(bitmap_b));
+    for (CBITMAP_OP op = OP_AND; op <= OP_ANDNOT; ++op) {
+        cbitmap_t *bitmap_c = cbitmap_create(TEST_BITS);
+        assert(bitmap_c);
+        assert(cbitmap_or(bitmap_c, bitmap_a));
+        assert(ops[op](bitmap_c, bitmap_b));
+        for (size_t bit = 0; bit < TEST_BITS; ++bit) {
+            switch (op) {
+                case OP_AND:
+                    expected[bit] = reference_a[bit] && reference_b[bit];
+                    break;
+                case OP_OR:
+                    expected[bit] = reference_a[bit] || reference_b[bit];
+                    break;
+                case OP_XOR:
+                    expected[bit] = reference_a[bit] != reference_b[bit];
+                    break;
+                default:
+                    expected[bit] = reference_a[bit] && !reference_b[bit];
+            }
+        }
+        assert(cbitmap_matches(bitmap_c, expected));
+        cbitmap_destroy(bitmap_c);
+    }
+    assert(cbitmap_xor(bitmap_b, bitmap_b));
+    assert(bitmap_b->count == 0);
+    assert(cbitmap_ffs(bitmap_b) == SIZE_MAX);
+
+    // 11
+    cbitmap_t *bitmap_short = cbitmap_create(TEST_BITS - 1);
+    assert(bitmap_short);
+    assert(cbitmap_and(bitmap_a, bitmap_short) == false);
+    assert(cbitmap_or(NULL, bitmap_a) == false);
+    assert(cbitmap_xor(bitmap_a, NULL) == false);
+    assert(cbitmap_matches(bitmap_a, reference_a));
+
+    cbitmap_destroy(bitmap_short);
+    cbitmap_destroy(bitmap_a);
+    cbitmap_destroy(bitmap_b);
+}
+
+void cbitmap_test_c() {
+    static bool reference[TEST_BITS];
+    cbitmap_t *bitmap_a = cbitmap_create(TEST_BITS);
+    assert(bitmap_a);
+
+    // 12
+    size_t size = cbitmap_serialized_size(bitmap_a);
+    uint8_t *buffer = (uint8_t *) malloc(size);
+    assert(buffer);
+    assert(cbitmap_serialize(bitmap_a, buffer, size) == size);
+    cbitmap_t *bitmap_b = cbitmap_deserialize(buffer, size);
+    assert(bitmap_b);
+    assert(cbitmap_get_bits(bitmap_b) == TEST_BITS);
+    assert(cbitmap_matches(bitmap_b, reference));
+    cbitmap_destroy(bitmap_b);
+    free(buffer);
+
+    cbitmap_fill(bitmap_a, reference, 3);
+    assert(cbitmap_set(bitmap_a, TEST_BITS - 1));
+    reference[TEST_BITS - 1] = true;
+    assert(cbitmap_optimize(bitmap_a));
+    size = cbitmap_serialized_size(bitmap_a);
+    buffer = (uint8_t *) malloc(size);
+    assert(buffer);
+    assert(cbitmap_serialize(bitmap_a, buffer, size) == size);
+    bitmap_b = cbitmap_deserialize(buffer, size);
+    assert(bitmap_b);
+    assert(bitmap_b->count == bitmap_a->count);
+    assert(bitmap_b->containers[2].type == RUN_CONTAINER);
+    assert(cbitmap_matches(bitmap_b, reference));
+    cbitmap_destroy(bitmap_b);
+
+    // 13
+    assert(cbitmap_serialize(bitmap_a, buffer, size - 1) == 0);
+    assert(cbitmap_serialize(NULL, buffer, size) == 0);
+    assert(cbitmap_serialize(bitmap_a, NULL, size) == 0);
+    assert(cbitmap_serialized_size(NULL) == 0);
+    assert(cbitmap_deserialize(buffer, size - 1) == NULL);
+    assert(cbitmap_deserialize(buffer, 10) == NULL);
+    assert(cbitmap_deserialize(NULL, size) == NULL);
+    // magic
+    buffer[0] ^= 0xFF;
+    assert(cbitmap_deserialize(buffer, size) == NULL);
+    buffer[0] ^= 0xFF;
+    // first container is an array, make its first two values out of order
+    const size_t first_value = SERIAL_HEADER_BYTES + SERIAL_CONTAINER_BYTES;
+    const uint8_t saved[4] = {buffer[first_value], buffer[first_value + 1], buffer[first_value + 2], buffer[first_value + 3]};
+    buffer[first_value + 2] = saved[0];
+    buffer[first_value + 3] = saved[1];
+    buffer[first_value] = saved[2];
+    buffer[first_value + 1] = saved[3];
+    assert(cbitmap_deserialize(buffer, size) == NULL);
+    memcpy(buffer + first_value, saved, 4);
+    // bit count that cuts off the last bit set
+    buffer[4] -= 1;
+    assert(cbitmap_deserialize(buffer, size) == NULL);
+    buffer[4] += 1;
+    bitmap_b = cbitmap_deserialize(buffer, size);
+    assert(bitmap_b);
+    cbitmap_destroy(bitmap_b);
+
+    free(buffer);
+    cbitmap_destroy(bitmap_a);
+}
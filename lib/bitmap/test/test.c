@@ -1,3 +1,6 @@
+// Split scans up way earlier than usual so the threaded paths get run on test-sized bitmaps
+#define BITMAP_PARALLEL_MIN_WORDS 16
+
 #include "../include/bitmap.h"
 #include "../src/bitmap.c"
 
@@ -6,6 +9,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 
 /*
     // Sets requested bit in bitmap
@@ -93,6 +97,105 @@
     32. Normal, all bits set
     33. Normal, with weird bit count
     34. Fail, NULL
+
+    void bitmap_set_range(bitmap_t *const bitmap, const size_t start, const size_t end);
+    void bitmap_reset_range(bitmap_t *const bitmap, const size_t start, const size_t end);
+    35. Normal, range inside one word
+    36. Normal, range across several words (head, middle, tail)
+    37. Normal, overlay that ends mid-word
+    38. Fail, empty range, range past the end, NULL
+
+    bool bitmap_test_range_all(const bitmap_t *const bitmap, const size_t start, const size_t end);
+    bool bitmap_test_range_any(const bitmap_t *const bitmap, const size_t start, const size_t end);
+    size_t bitmap_count_range(const bitmap_t *const bitmap, const size_t start, const size_t end);
+    39. Normal, all/none/some set
+    40. Fail, empty range, range past the end, NULL
+
+    size_t bitmap_find_zero_run(const bitmap_t *const bitmap, const size_t n_bits, const size_t hint);
+    41. Normal, run found at/after hint, across words, at the very end
+    42. Normal, no run long enough
+    43. Fail, zero length, longer than bitmap, NULL
+
+    size_t bitmap_longest_zero_run(const bitmap_t *const bitmap, size_t *const run_start);
+    44. Normal, some runs, ends with a run, full, empty
+    45. Fail, NULL
+
+    Bulk kernels (whichever set got picked at load vs. the scalar ones)
+    46. Popcount, invert, scan, combine, compare on odd lengths and offsets, random data (every set the CPU can run)
+    47. Scan finds the first interesting word at every position, finds nothing in a uniform buffer
+    48. Total set, count range, ffs/ffz on a bitmap big enough to take the wide paths
+
+    bool bitmap_summarize(bitmap_t *const bitmap);
+    49. Normal, searches agree with a plain bitmap through set/reset/flip/ranges/invert/format
+    50. Normal, overlay written behind our back, summarize again
+    51. Fail, NULL
+
+    bool bitmap_test_and_set(bitmap_t *const bitmap, const size_t bit);
+    bool bitmap_test_and_reset(bitmap_t *const bitmap, const size_t bit);
+    52. Normal, reports the old value, aligned words and a misaligned overlay
+    53. Fail, past the end, NULL
+
+    size_t bitmap_ffz_and_claim(bitmap_t *const bitmap, const size_t hint);
+    54. Normal, claims from hint, wraps, fills up, misaligned overlay
+    55. Normal, several threads claim everything with no bit handed out twice (summarized, ffz agrees after)
+    56. Fail, NULL
+
+    bool bitmap_and(bitmap_t *const bitmap, const bitmap_t *const other);
+    bool bitmap_and_to(bitmap_t *const dest, const bitmap_t *const a, const bitmap_t *const b);
+    (and the same for or, xor, andnot)
+    57. Normal, every op in both forms matches a bit-by-bit version, overlay that ends mid-word
+    58. Fail, size mismatch, NULL
+
+    bool bitmap_equal(const bitmap_t *const a, const bitmap_t *const b);
+    bool bitmap_intersects(const bitmap_t *const a, const bitmap_t *const b);
+    59. Normal, equal/not equal (including a difference only in the last bit), intersecting/disjoint
+    60. Normal, garbage past the end doesn't count
+    61. Fail, size mismatch, NULL
+
+    size_t bitmap_extract_set(const bitmap_t *const bitmap, size_t *const out_indices, const size_t max, size_t *const cursor);
+    62. Normal, batches that stop mid-word and on word edges, cursor ends at the bit count, agrees with for_each
+    63. Normal, empty bitmap, cursor past the end, max of 0
+    64. Fail, NULL
+
+    bool bitmap_next_run(const bitmap_t *const bitmap, size_t *const pos, size_t *const start, size_t *const length);
+    65. Normal, single bits, runs across words, run to the very end, whole bitmap as one run
+    66. Normal, empty bitmap, pos past the end
+    67. Fail, NULL
+
+    bool bitmap_build_rank_index(bitmap_t *const bitmap);
+    size_t bitmap_rank(const bitmap_t *const bitmap, const size_t bit);
+    size_t bitmap_select(const bitmap_t *const bitmap, const size_t k);
+    68. Normal, rank/select agree with a running count at every position, with and without the index
+    69. Normal, index catches up after set/reset/ranges/invert/format, overlay that ends mid-word
+    70. Fail, select past the last set bit, NULL
+
+    bool bitmap_track_count(bitmap_t *const bitmap);
+    71. Normal, count stays exact through set/reset/flip/ranges/format/invert/boolean ops/atomics
+    72. Normal, overlay resyncs after its memory gets written behind its back
+    73. Fail, NULL
+
+    bitmap_t *bitmap_map_file(const char *const path, const size_t n_bits, const BITMAP_MAP_FLAGS flags);
+    bool bitmap_sync(bitmap_t *const bitmap, const bool wait);
+    74. Normal, new file comes out zeroed and the right size, bits survive an unmap and remap (populated too)
+    75. Normal, existing larger file is left alone, sync on a mapped and an unmapped bitmap
+    76. Fail, NULL path, bad path, zero bits, NULL sync
+
+    uint64_t bitmap_load_word(const bitmap_t *const bitmap, const size_t word);
+    void bitmap_store_word(bitmap_t *const bitmap, const size_t word, const uint64_t value);
+    (and the bitmap_inline.h versions of those and test/set/reset/flip)
+    77. Normal, inline and library calls agree on a plain bitmap and an overlay that ends mid-word
+    78. Normal, inline writes on a summarized/counted bitmap keep the summary and count right
+    79. Fail, word past the end, NULL
+
+    void bitmap_for_each_unordered(const bitmap_t *const bitmap, void (*func)(size_t, void *), void *args);
+    void bitmap_set_threads(const size_t threads);
+    (and the threaded total_set/find_zero_run/longest_zero_run)
+    80. Normal, threaded and single threaded agree on total_set/zero runs at several fills, runs across chunks
+    81. Normal, for_each_unordered visits every set bit once, small bitmaps stay in order
+    82. Fail, NULL
+
+    (the atomic functions on a summarized/ranked/counted bitmap)
+    83. Normal, ffz/ffs/rank/total_set stay right through test_and_set/reset and claims, misaligned overlay too
 */
 
 bool memcmp_fixed(const uint8_t *const data, uint8_t fixed_value, size_t nbytes) {
@@ -121,6 +224,32 @@ void bitmap_test_b();
 
 void bitmap_test_c();
 
+void bitmap_test_d();
+
+void bitmap_test_e();
+
+void bitmap_test_f();
+
+void bitmap_test_g();
+
+void bitmap_test_h();
+
+void bitmap_test_i();
+
+void bitmap_test_j();
+
+void bitmap_test_k();
+
+void bitmap_test_l();
+
+void bitmap_test_m();
+
+void bitmap_test_n();
+
+void bitmap_test_o();
+
+void bitmap_test_p();
+
 int main() {
 
     // EVERYTHING ELSE
@@ -132,6 +261,45 @@ int main() {
     // OVERLAY INVERT TOTAL_SET
     bitmap_test_c();
 
+    // RANGES
+    bitmap_test_d();
+
+    // ZERO RUNS
+    bitmap_test_e();
+
+    // KERNELS
+    bitmap_test_f();
+
+    // SUMMARY
+    bitmap_test_g();
+
+    // ATOMICS
+    bitmap_test_h();
+
+    // BOOLEAN OPS
+    bitmap_test_i();
+
+    // EXTRACT
+    bitmap_test_j();
+
+    // RUNS
+    bitmap_test_k();
+
+    // RANK/SELECT
+    bitmap_test_l();
+
+    // COUNTING
+    bitmap_test_m();
+
+    // MAPPED FILES
+    bitmap_test_n();
+
+    // INLINE/WORDS
+    bitmap_test_o();
+
+    // THREADS
+    bitmap_test_p();
+
     // Done. GO TEAM!
 
     puts("TESTS PASSED");
@@ -556,6 +724,101 @@ void bitmap_test_b() {
     assert(bitmap_ffz(bitmap_A) == 57);
 
     bitmap_destroy(bitmap_A);
+
+    // Now across word boundaries, with garbage past the end that we should never report
+    const size_t wide_bit_count = 200; // 3 words and change
+    bitmap_A = bitmap_create(wide_bit_count);
+    assert(bitmap_A);
+    assert(bitmap_A->word_count == 4);
+
+    assert(bitmap_ffs(bitmap_A) == SIZE_MAX);
+    bitmap_set(bitmap_A, 64);
+    assert(bitmap_ffs(bitmap_A) == 64);
+    bitmap_set(bitmap_A, 63);
+    assert(bitmap_ffs(bitmap_A) == 63);
+    bitmap_reset(bitmap_A, 63);
+    bitmap_reset(bitmap_A, 64);
+    bitmap_set(bitmap_A, wide_bit_count - 1);
+    assert(bitmap_ffs(bitmap_A) == wide_bit_count - 1);
+
+    bitmap_format(bitmap_A, 0xFF);
+    assert(bitmap_ffz(bitmap_A) == SIZE_MAX);
+    bitmap_reset(bitmap_A, 130);
+    assert(bitmap_ffz(bitmap_A) == 130);
+    bitmap_set(bitmap_A, 130);
+    bitmap_reset(bitmap_A, wide_bit_count - 1);
+    assert(bitmap_ffz(bitmap_A) == wide_bit_count - 1);
+
+    bitmap_destroy(bitmap_A);
+
+    // Resumable searches and the FLX family
+    bitmap_A = bitmap_create(wide_bit_count);
+    assert(bitmap_fls(bitmap_A) == SIZE_MAX);
+    assert(bitmap_flz(bitmap_A) == wide_bit_count - 1);
+    assert(bitmap_ffs_from(bitmap_A, 0) == SIZE_MAX);
+    assert(bitmap_ffz_from(bitmap_A, 150) == 150);
+
+    bitmap_set(bitmap_A, 3);
+    bitmap_set(bitmap_A, 64);
+    bitmap_set(bitmap_A, 127);
+    bitmap_set(bitmap_A, 199);
+
+    assert(bitmap_ffs_from(bitmap_A, 0) == 3);
+    assert(bitmap_ffs_from(bitmap_A, 3) == 3);
+    assert(bitmap_ffs_from(bitmap_A, 4) == 64);
+    assert(bitmap_ffs_from(bitmap_A, 65) == 127);
+    assert(bitmap_ffs_from(bitmap_A, 128) == 199);
+    assert(bitmap_ffs_from(bitmap_A, 200) == SIZE_MAX);
+    assert(bitmap_ffs_from(bitmap_A, SIZE_MAX) == SIZE_MAX);
+    assert(bitmap_ffs_from(NULL, 0) == SIZE_MAX);
+
+    assert(bitmap_fls(bitmap_A) == 199);
+    assert(bitmap_fls_before(bitmap_A, 199) == 127);
+    assert(bitmap_fls_before(bitmap_A, 127) == 64);
+    assert(bitmap_fls_before(bitmap_A, 64) == 3);
+    assert(bitmap_fls_before(bitmap_A, 3) == SIZE_MAX);
+    assert(bitmap_fls_before(bitmap_A, 0) == SIZE_MAX);
+    assert(bitmap_fls_before(bitmap_A, SIZE_MAX) == 199);
+    assert(bitmap_fls(NULL) == SIZE_MAX);
+
+    bitmap_format(bitmap_A, 0xFF);
+    bitmap_reset(bitmap_A, 0);
+    bitmap_reset(bitmap_A, 63);
+    bitmap_reset(bitmap_A, 128);
+
+    assert(bitmap_ffz_from(bitmap_A, 0) == 0);
+    assert(bitmap_ffz_from(bitmap_A, 1) == 63);
+    assert(bitmap_ffz_from(bitmap_A, 64) == 128);
+    assert(bitmap_ffz_from(bitmap_A, 129) == SIZE_MAX); // tail garbage is set, but it's not ours
+
+    assert(bitmap_flz(bitmap_A) == 128);
+    assert(bitmap_flz_before(bitmap_A, 128) == 63);
+    assert(bitmap_flz_before(bitmap_A, 63) == 0);
+    assert(bitmap_flz_before(bitmap_A, 0) == SIZE_MAX);
+    assert(bitmap_flz(NULL) == SIZE_MAX);
+
+    bitmap_destroy(bitmap_A);
+
+    // Overlay that ends mid-word and isn't word aligned
+    uint8_t raw[13];
+    memset(raw, 0xFF, 13);
+    bitmap_A = bitmap_overlay(90, raw + 1); // 11.25 bytes, so 12
+    assert(bitmap_A);
+    assert(bitmap_A->full_words == 1);
+    assert(bitmap_ffz(bitmap_A) == SIZE_MAX);
+    raw[11] = 0xFD;
+    assert(bitmap_ffz(bitmap_A) == 81);
+    raw[11] = 0xFF;
+    raw[12] = 0x03; // 88 and 89 are ours, the rest is past the end
+    assert(bitmap_ffz(bitmap_A) == SIZE_MAX);
+    memset(raw, 0x00, 13);
+    assert(bitmap_ffs(bitmap_A) == SIZE_MAX);
+    raw[12] = 0x80; // past the end, not ours
+    assert(bitmap_ffs(bitmap_A) == SIZE_MAX);
+    raw[11] = 0x02;
+    assert(bitmap_ffs(bitmap_A) == 81);
+    assert(bitmap_fls(bitmap_A) == 81);
+    bitmap_destroy(bitmap_A);
 }
 
 void bitmap_test_c() {
@@ -627,4 +890,1017 @@ void bitmap_test_c() {
     assert(bitmap_a);
     assert(bitmap_total_set(bitmap_a) == 35);
 
-}
\ No newline at end of file
+}
+
+void bitmap_test_d() {
+    bitmap_t *bitmap_a;
+    const size_t test_bit_count = 300; // 4.6875 words
+
+    bitmap_a = bitmap_create(test_bit_count);
+    assert(bitmap_a);
+
+    // 35
+    bitmap_set_range(bitmap_a, 3, 13);
+    assert(bitmap_a->data[0] == 0xF8);
+    assert(bitmap_a->data[1] == 0x1F);
+    assert(memcmp_fixed(bitmap_a->data + 2, 0x00, bitmap_a->byte_count - 2));
+    bitmap_reset_range(bitmap_a, 4, 12);
+    assert(bitmap_a->data[0] == 0x08);
+    assert(bitmap_a->data[1] == 0x10);
+
+    // 39
+    assert(bitmap_test_range_all(bitmap_a, 3, 4));
+    assert(bitmap_test_range_all(bitmap_a, 3, 5) == false);
+    assert(bitmap_test_range_any(bitmap_a, 4, 12) == false);
+    assert(bitmap_test_range_any(bitmap_a, 4, 13));
+    assert(bitmap_count_range(bitmap_a, 0, test_bit_count) == 2);
+    assert(bitmap_count_range(bitmap_a, 4, 12) == 0);
+
+    // 36
+    bitmap_format(bitmap_a, 0x00);
+    bitmap_set_range(bitmap_a, 60, 260);
+    assert(bitmap_ffs(bitmap_a) == 60);
+    assert(bitmap_ffz_from(bitmap_a, 60) == 260);
+    assert(bitmap_count_range(bitmap_a, 0, test_bit_count) == 200);
+    assert(bitmap_count_range(bitmap_a, 59, 61) == 1);
+    assert(bitmap_count_range(bitmap_a, 100, 200) == 100);
+    assert(bitmap_test_range_all(bitmap_a, 60, 260));
+    assert(bitmap_test_range_all(bitmap_a, 59, 260) == false);
+    assert(bitmap_test_range_all(bitmap_a, 60, 261) == false);
+    assert(bitmap_test_range_any(bitmap_a, 0, 60) == false);
+    assert(bitmap_test_range_any(bitmap_a, 260, test_bit_count) == false);
+    assert(bitmap_test_range_any(bitmap_a, 0, 61));
+
+    bitmap_reset_range(bitmap_a, 64, 256);
+    assert(bitmap_count_range(bitmap_a, 0, test_bit_count) == 8);
+    assert(bitmap_a->data[7] == 0xF0);
+    assert(memcmp_fixed(bitmap_a->data + 8, 0x00, 24));
+    assert(bitmap_a->data[32] == 0x0F);
+
+    bitmap_set_range(bitmap_a, 0, test_bit_count);
+    assert(bitmap_ffz(bitmap_a) == SIZE_MAX);
+    assert(bitmap_total_set(bitmap_a) == test_bit_count);
+
+    // 38
+    bitmap_reset_range(bitmap_a, 10, 10);
+    bitmap_reset_range(bitmap_a, 20, 10);
+    bitmap_reset_range(bitmap_a, 290, test_bit_count + 1);
+    bitmap_reset_range(NULL, 0, 10);
+    assert(bitmap_total_set(bitmap_a) == test_bit_count);
+
+    // 40
+    assert(bitmap_test_range_all(bitmap_a, 10, 10) == false);
+    assert(bitmap_test_range_all(bitmap_a, 0, test_bit_count + 1) == false);
+    assert(bitmap_test_range_all(NULL, 0, 10) == false);
+    assert(bitmap_test_range_any(bitmap_a, 10, 10) == false);
+    assert(bitmap_test_range_any(bitmap_a, 0, test_bit_count + 1) == false);
+    assert(bitmap_test_range_any(NULL, 0, 10) == false);
+    assert(bitmap_count_range(bitmap_a, 10, 10) == 0);
+    assert(bitmap_count_range(bitmap_a, 0, test_bit_count + 1) == 0);
+    assert(bitmap_count_range(NULL, 0, 10) == 0);
+
+    bitmap_destroy(bitmap_a);
+
+    // 37
+    uint8_t arr[22];
+    memset(arr, 0x00, 22);
+    bitmap_a = bitmap_overlay(168, arr + 1); // 21 bytes, last word is 5 bytes short
+    assert(bitmap_a);
+    bitmap_set_range(bitmap_a, 1, 168);
+    assert(arr[0] == 0x00);
+    assert(arr[1] == 0xFE);
+    assert(memcmp_fixed(arr + 2, 0xFF, 20));
+    assert(bitmap_count_range(bitmap_a, 0, 168) == 167);
+    bitmap_reset_range(bitmap_a, 130, 167);
+    assert(bitmap_fls(bitmap_a) == 167);
+    assert(bitmap_fls_before(bitmap_a, 167) == 129);
+    bitmap_destroy(bitmap_a);
+}
+
+void bitmap_test_e() {
+    bitmap_t *bitmap_a;
+    const size_t test_bit_count = 300;
+    size_t run_start = 0;
+
+    bitmap_a = bitmap_create(test_bit_count);
+    assert(bitmap_a);
+
+    // 44
+    assert(bitmap_longest_zero_run(bitmap_a, &run_start) == test_bit_count);
+    assert(run_start == 0);
+
+    bitmap_format(bitmap_a, 0xFF);
+    assert(bitmap_longest_zero_run(bitmap_a, &run_start) == 0);
+    assert(run_start == SIZE_MAX);
+
+    // 42
+    assert(bitmap_find_zero_run(bitmap_a, 1, 0) == SIZE_MAX);
+
+    // holes of 3 @ 10, 70 @ 50 (spans a word boundary), 5 @ 200, 4 @ the very end
+    bitmap_reset_range(bitmap_a, 10, 13);
+    bitmap_reset_range(bitmap_a, 50, 120);
+    bitmap_reset_range(bitmap_a, 200, 205);
+    bitmap_reset_range(bitmap_a, 296, 300);
+
+    // 41
+    assert(bitmap_find_zero_run(bitmap_a, 1, 0) == 10);
+    assert(bitmap_find_zero_run(bitmap_a, 3, 0) == 10);
+    assert(bitmap_find_zero_run(bitmap_a, 4, 0) == 50);
+    assert(bitmap_find_zero_run(bitmap_a, 70, 0) == 50);
+    assert(bitmap_find_zero_run(bitmap_a, 4, 11) == 50);
+    assert(bitmap_find_zero_run(bitmap_a, 2, 11) == 11);
+    assert(bitmap_find_zero_run(bitmap_a, 5, 60) == 60);
+    assert(bitmap_find_zero_run(bitmap_a, 5, 116) == 200);
+    assert(bitmap_find_zero_run(bitmap_a, 4, 201) == 201);
+    assert(bitmap_find_zero_run(bitmap_a, 4, 202) == 296);
+
+    // 42
+    assert(bitmap_find_zero_run(bitmap_a, 71, 0) == SIZE_MAX);
+    assert(bitmap_find_zero_run(bitmap_a, 6, 120) == SIZE_MAX);
+    assert(bitmap_find_zero_run(bitmap_a, 5, 297) == SIZE_MAX);
+
+    // 43
+    assert(bitmap_find_zero_run(bitmap_a, 0, 0) == SIZE_MAX);
+    assert(bitmap_find_zero_run(bitmap_a, test_bit_count + 1, 0) == SIZE_MAX);
+    assert(bitmap_find_zero_run(NULL, 1, 0) == SIZE_MAX);
+
+    // 44
+    assert(bitmap_longest_zero_run(bitmap_a, &run_start) == 70);
+    assert(run_start == 50);
+    bitmap_set_range(bitmap_a, 50, 120);
+    assert(bitmap_longest_zero_run(bitmap_a, &run_start) == 5);
+    assert(run_start == 200);
+    bitmap_reset_range(bitmap_a, 290, 300);
+    assert(bitmap_longest_zero_run(bitmap_a, NULL) == 10);
+    assert(bitmap_longest_zero_run(bitmap_a, &run_start) == 10);
+    assert(run_start == 290);
+
+    // 45
+    assert(bitmap_longest_zero_run(NULL, &run_start) == 0);
+    assert(run_start == SIZE_MAX);
+
+    bitmap_destroy(bitmap_a);
+}
+
+// 46 and 47 for one set of kernels
+void kernel_test(const bitmap_kernels_t *const set) {
+    const size_t test_words = 67;
+    uint8_t data[67 * 8 + 8], expected[67 * 8 + 8], combined[67 * 8];
+    srand(0x0F15);
+    for (size_t byte = 0; byte < sizeof(data); ++byte) {
+        data[byte] = rand();
+    }
+
+    // 46
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t words = 0; words <= test_words; ++words) {
+            assert(set->popcount(data + offset, words) == scalar_popcount(data + offset, words));
+            assert(set->scan(data + offset, words, 0) == scalar_scan(data + offset, words, 0));
+            assert(set->scan(data + offset, words, ~((uint64_t) 0)) == scalar_scan(data + offset, words, ~((uint64_t) 0)));
+            for (BITMAP_OP op = OP_AND; op <= OP_ANDNOT; ++op) {
+                assert(set->compare(data + offset, data, words, op) == scalar_compare(data + offset, data, words, op));
+                set->combine(combined, data + offset, data, words, op);
+                scalar_combine(expected, data + offset, data, words, op);
+                assert(memcmp(combined, expected, words * 8) == 0);
+            }
+            memcpy(expected, data, sizeof(data));
+            scalar_invert(expected + offset, words);
+            set->invert(data + offset, words);
+            assert(memcmp(data, expected, sizeof(data)) == 0);
+        }
+    }
+
+    // 47
+    memset(data, 0x00, sizeof(data));
+    assert(set->scan(data, test_words, 0) == test_words);
+    assert(set->scan(data, test_words, ~((uint64_t) 0)) == 0);
+    for (size_t word = 0; word < test_words; ++word) {
+        data[word * 8 + 5] = 0x10;
+        assert(set->scan(data, test_words, 0) == word);
+        data[word * 8 + 5] = 0x00;
+    }
+    memset(data, 0xFF, sizeof(data));
+    assert(set->scan(data, test_words, ~((uint64_t) 0)) == test_words);
+    for (size_t word = 0; word < test_words; ++word) {
+        data[word * 8 + 7] = 0x7F;
+        assert(set->scan(data, test_words, ~((uint64_t) 0)) == word);
+        data[word * 8 + 7] = 0xFF;
+    }
+}
+
+void bitmap_test_f() {
+    kernel_test(&kernels);
+#ifdef BITMAP_X86_KERNELS
+    // Whatever got picked at load, run every set this CPU can run, so the lower tiers don't go untested
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        const bitmap_kernels_t sse42 = {&popcnt_popcount, &sse42_invert, &sse42_scan, &sse42_combine, &sse42_compare};
+        kernel_test(&sse42);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        const bitmap_kernels_t avx2 = {&avx2_popcount, &avx2_invert, &avx2_scan, &avx2_combine, &avx2_compare};
+        kernel_test(&avx2);
+    }
+#endif
+
+    // 48
+    const size_t test_bit_count = 4000;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    assert(bitmap_a);
+    assert(bitmap_ffs(bitmap_a) == SIZE_MAX);
+    bitmap_set(bitmap_a, 3333);
+    assert(bitmap_ffs(bitmap_a) == 3333);
+    assert(bitmap_ffs_from(bitmap_a, 100) == 3333);
+    assert(bitmap_total_set(bitmap_a) == 1);
+    bitmap_invert(bitmap_a);
+    assert(bitmap_ffz(bitmap_a) == 3333);
+    assert(bitmap_ffz_from(bitmap_a, 70) == 3333);
+    assert(bitmap_total_set(bitmap_a) == test_bit_count - 1);
+    assert(bitmap_count_range(bitmap_a, 1, 3999) == 3997);
+    assert(bitmap_count_range(bitmap_a, 64, 3968) == 3903);
+    bitmap_reset(bitmap_a, 3999);
+    assert(bitmap_ffz_from(bitmap_a, 3334) == 3999);
+    assert(bitmap_total_set(bitmap_a) == test_bit_count - 2);
+    bitmap_destroy(bitmap_a);
+}
+
+// Every search from every position has to match between the two
+bool bitmap_searches_match(const bitmap_t *const plain, const bitmap_t *const summarized) {
+    for (size_t bit = 0; bit <= bitmap_get_bits(plain); ++bit) {
+        if (bitmap_ffs_from(plain, bit) != bitmap_ffs_from(summarized, bit) ||
+                bitmap_ffz_from(plain, bit) != bitmap_ffz_from(summarized, bit)) {
+            return false;
+        }
+    }
+    return bitmap_ffs(plain) == bitmap_ffs(summarized) && bitmap_ffz(plain) == bitmap_ffz(summarized);
+}
+
+void bitmap_test_g() {
+    // More than 64 words, and not a multiple of 64 bits, so both summary words and the data tail are partial
+    const size_t test_bit_count = 4200;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_b = bitmap_create(test_bit_count);
+    assert(bitmap_a && bitmap_b);
+
+    // 49
+    assert(bitmap_summarize(bitmap_b));
+    assert(bitmap_searches_match(bitmap_a, bitmap_b));
+    srand(0x0F15);
+    for (int round = 0; round < 200; ++round) {
+        const size_t bit = rand() % test_bit_count;
+        switch (rand() % 3) {
+            case 0:
+                bitmap_set(bitmap_a, bit);
+                bitmap_set(bitmap_b, bit);
+                break;
+            case 1:
+                bitmap_reset(bitmap_a, bit);
+                bitmap_reset(bitmap_b, bit);
+                break;
+            default:
+                bitmap_flip(bitmap_a, bit);
+                bitmap_flip(bitmap_b, bit);
+        }
+    }
+    assert(bitmap_searches_match(bitmap_a, bitmap_b));
+    bitmap_set_range(bitmap_a, 100, 4150);
+    bitmap_set_range(bitmap_b, 100, 4150);
+    bitmap_reset(bitmap_a, 4000);
+    bitmap_reset(bitmap_b, 4000);
+    assert(bitmap_ffz_from(bitmap_b, 100) == 4000);
+    assert(bitmap_searches_match(bitmap_a, bitmap_b));
+    bitmap_invert(bitmap_a);
+    bitmap_invert(bitmap_b);
+    assert(bitmap_ffs_from(bitmap_b, 100) == 4000);
+    assert(bitmap_searches_match(bitmap_a, bitmap_b));
+    bitmap_reset_range(bitmap_a, 0, test_bit_count);
+    bitmap_reset_range(bitmap_b, 0, test_bit_count);
+    assert(bitmap_ffs(bitmap_b) == SIZE_MAX);
+    bitmap_format(bitmap_a, 0xFF);
+    bitmap_format(bitmap_b, 0xFF);
+    assert(bitmap_ffz(bitmap_b) == SIZE_MAX);
+    bitmap_reset(bitmap_b, test_bit_count - 1);
+    assert(bitmap_ffz(bitmap_b) == test_bit_count - 1);
+    assert(bitmap_find_zero_run(bitmap_b, 1, 0) == test_bit_count - 1);
+    bitmap_destroy(bitmap_a);
+    bitmap_destroy(bitmap_b);
+
+    // 50
+    uint8_t raw[600] = {0};
+    bitmap_a = bitmap_overlay(test_bit_count, raw);
+    assert(bitmap_a);
+    assert(bitmap_summarize(bitmap_a));
+    assert(bitmap_ffs(bitmap_a) == SIZE_MAX);
+    raw[300] = 0x04;
+    assert(bitmap_summarize(bitmap_a));
+    assert(bitmap_ffs(bitmap_a) == 2402);
+    bitmap_destroy(bitmap_a);
+
+    // 51
+    assert(bitmap_summarize(NULL) == false);
+}
+
+#define CLAIM_THREADS 4
+#define CLAIM_BITS 4000
+
+typedef struct {
+    bitmap_t *bitmap;
+    size_t hint;
+    size_t claimed[CLAIM_BITS];
+    size_t count;
+} claim_args_t;
+
+void *claim_thread(void *args) {
+    claim_args_t *claim = (claim_args_t *) args;
+    size_t bit;
+    while ((bit = bitmap_ffz_and_claim(claim->bitmap, claim->hint)) != SIZE_MAX) {
+        claim->claimed[claim->count++] = bit;
+    }
+    return NULL;
+}
+
+void bitmap_test_h() {
+    bitmap_t *bitmap_a = bitmap_create(200);
+    assert(bitmap_a);
+
+    // 52
+    assert(bitmap_test_and_set(bitmap_a, 70) == false);
+    assert(bitmap_test(bitmap_a, 70));
+    assert(bitmap_test_and_set(bitmap_a, 70) == true);
+    assert(bitmap_test_and_reset(bitmap_a, 70) == true);
+    assert(bitmap_test(bitmap_a, 70) == false);
+    assert(bitmap_test_and_reset(bitmap_a, 70) == false);
+    assert(bitmap_test_and_set(bitmap_a, 199) == false);
+    assert(bitmap_ffs(bitmap_a) == 199);
+
+    // 53
+    assert(bitmap_test_and_set(bitmap_a, 200) == false);
+    assert(bitmap_test_and_reset(bitmap_a, 200) == false);
+    assert(bitmap_test_and_set(NULL, 0) == false);
+    assert(bitmap_test_and_reset(NULL, 0) == false);
+    bitmap_destroy(bitmap_a);
+
+    // 83
+    bitmap_a = bitmap_create(200);
+    assert(bitmap_a);
+    assert(bitmap_summarize(bitmap_a) && bitmap_build_rank_index(bitmap_a) && bitmap_track_count(bitmap_a));
+    bitmap_set_range(bitmap_a, 0, 64);
+    assert(bitmap_ffz(bitmap_a) == 64);
+    for (size_t bit = 64; bit < 128; ++bit) {
+        assert(bitmap_ffz_and_claim(bitmap_a, 0) == bit);
+    }
+    assert(bitmap_ffz(bitmap_a) == 128);
+    assert(bitmap_rank(bitmap_a, 128) == 128 && bitmap_total_set(bitmap_a) == 128);
+    assert(bitmap_test_and_reset(bitmap_a, 70) == true);
+    assert(bitmap_ffz(bitmap_a) == 70 && bitmap_rank(bitmap_a, 128) == 127);
+    assert(bitmap_ffz_and_claim(bitmap_a, 0) == 70);
+    assert(bitmap_test_and_set(bitmap_a, 199) == false);
+    assert(bitmap_ffz(bitmap_a) == 128 && bitmap_total_set(bitmap_a) == 129);
+    bitmap_reset_range(bitmap_a, 0, 199);
+    assert(bitmap_ffs(bitmap_a) == 199);
+    assert(bitmap_test_and_reset(bitmap_a, 199) == true);
+    assert(bitmap_ffs(bitmap_a) == SIZE_MAX && bitmap_total_set(bitmap_a) == 0);
+    bitmap_set_range(bitmap_a, 0, 199);
+    assert(bitmap_ffz_and_claim(bitmap_a, 0) == 199);
+    assert(bitmap_ffz(bitmap_a) == SIZE_MAX && bitmap_ffz_and_claim(bitmap_a, 0) == SIZE_MAX);
+    bitmap_destroy(bitmap_a);
+
+    uint8_t raw_summarized[13] = {0};
+    bitmap_a = bitmap_overlay(90, raw_summarized + 1);
+    assert(bitmap_a);
+    assert(bitmap_summarize(bitmap_a));
+    for (size_t bit = 0; bit < 90; ++bit) {
+        assert(bitmap_ffz_and_claim(bitmap_a, 0) == bit);
+        assert(bitmap_ffz(bitmap_a) == (bit == 89 ? SIZE_MAX : bit + 1));
+    }
+    assert(bitmap_test_and_reset(bitmap_a, 3) == true);
+    assert(bitmap_ffz(bitmap_a) == 3);
+    bitmap_destroy(bitmap_a);
+
+    // 54
+    bitmap_a = bitmap_create(200);
+    assert(bitmap_a);
+    assert(bitmap_test_and_set(bitmap_a, 199) == false);
+    assert(bitmap_ffz_and_claim(bitmap_a, 0) == 0);
+    assert(bitmap_ffz_and_claim(bitmap_a, 0) == 1);
+    assert(bitmap_ffz_and_claim(bitmap_a, 198) == 198);
+    assert(bitmap_ffz_and_claim(bitmap_a, 198) == 2);
+    assert(bitmap_ffz_and_claim(bitmap_a, 500) == 3);
+    bitmap_set_range(bitmap_a, 4, 150);
+    assert(bitmap_ffz_and_claim(bitmap_a, 10) == 150);
+    bitmap_set_range(bitmap_a, 151, 198);
+    assert(bitmap_ffz_and_claim(bitmap_a, 10) == SIZE_MAX);
+    assert(bitmap_total_set(bitmap_a) == 200);
+    bitmap_destroy(bitmap_a);
+
+    uint8_t raw[13] = {0};
+    bitmap_a = bitmap_overlay(90, raw + 1);
+    assert(bitmap_a);
+    for (size_t bit = 0; bit < 90; ++bit) {
+        assert(bitmap_ffz_and_claim(bitmap_a, 45) == (bit + 45) % 90);
+    }
+    assert(bitmap_ffz_and_claim(bitmap_a, 45) == SIZE_MAX);
+    assert(raw[0] == 0x00 && raw[11] == 0xFF && raw[12] == 0x03);
+    assert(bitmap_test_and_reset(bitmap_a, 89) == true);
+    assert(raw[12] == 0x01);
+    bitmap_destroy(bitmap_a);
+
+    // 55
+    static claim_args_t claims[CLAIM_THREADS];
+    pthread_t threads[CLAIM_THREADS];
+    bitmap_a = bitmap_create(CLAIM_BITS);
+    assert(bitmap_a);
+    assert(bitmap_summarize(bitmap_a));
+    for (size_t idx = 0; idx < CLAIM_THREADS; ++idx) {
+        claims[idx].bitmap = bitmap_a;
+        claims[idx].hint = idx * 100;
+        claims[idx].count = 0;
+        assert(pthread_create(&threads[idx], NULL, claim_thread, &claims[idx]) == 0);
+    }
+    size_t total = 0;
+    bitmap_t *seen = bitmap_create(CLAIM_BITS);
+    assert(seen);
+    for (size_t idx = 0; idx < CLAIM_THREADS; ++idx) {
+        assert(pthread_join(threads[idx], NULL) == 0);
+        for (size_t claim = 0; claim < claims[idx].count; ++claim) {
+            assert(bitmap_test_and_set(seen, claims[idx].claimed[claim]) == false);
+        }
+        total += claims[idx].count;
+    }
+    assert(total == CLAIM_BITS);
+    assert(bitmap_total_set(bitmap_a) == CLAIM_BITS);
+    assert(bitmap_ffz(bitmap_a) == SIZE_MAX);
+    assert(bitmap_test_and_reset(bitmap_a, CLAIM_BITS / 2) == true);
+    assert(bitmap_ffz(bitmap_a) == CLAIM_BITS / 2);
+    bitmap_destroy(seen);
+    bitmap_destroy(bitmap_a);
+
+    // 56
+    assert(bitmap_ffz_and_claim(NULL, 0) == SIZE_MAX);
+}
+
+void bitmap_test_i() {
+    const size_t test_bit_count = 1000;
+    bool (*const in_place[4])(bitmap_t *const, const bitmap_t *const) = {bitmap_and, bitmap_or, bitmap_xor, bitmap_andnot};
+    bool (*const to[4])(bitmap_t *const, const bitmap_t *const, const bitmap_t *const) = {bitmap_and_to, bitmap_or_to, bitmap_xor_to, bitmap_andnot_to};
+    uint8_t raw_a[126], raw_b[126];
+    srand(0x0F15);
+    for (size_t byte = 0; byte < sizeof(raw_a); ++byte) {
+        raw_a[byte] = rand();
+        raw_b[byte] = rand();
+    }
+    // a is an overlay that ends mid-word and isn't aligned, b is ours
+    bitmap_t *bitmap_a = bitmap_overlay(test_bit_count, raw_a + 1);
+    bitmap_t *bitmap_b = bitmap_import(test_bit_count, raw_b);
+    bitmap_t *bitmap_c = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_d = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_short = bitmap_create(test_bit_count - 1);
+    assert(bitmap_a && bitmap_b && bitmap_c && bitmap_d && bitmap_short);
+
+    // 57
+    for (BITMAP_OP op = OP_AND; op <= OP_ANDNOT; ++op) {
+        assert(to[op](bitmap_c, bitmap_a, bitmap_b));
+        bitmap_format(bitmap_d, 0x00);
+        assert(bitmap_or(bitmap_d, bitmap_a));
+        assert(in_place[op](bitmap_d, bitmap_b));
+        for (size_t bit = 0; bit < test_bit_count; ++bit) {
+            const bool expected = word_combine(bitmap_test(bitmap_a, bit), bitmap_test(bitmap_b, bit), op) & 1;
+            assert(bitmap_test(bitmap_c, bit) == expected);
+            assert(bitmap_test(bitmap_d, bit) == expected);
+        }
+        assert(bitmap_equal(bitmap_c, bitmap_d));
+    }
+    // into an overlay, and with dest as the second operand
+    assert(bitmap_xor_to(bitmap_c, bitmap_a, bitmap_b));
+    assert(bitmap_xor_to(bitmap_a, bitmap_b, bitmap_a));
+    assert(bitmap_equal(bitmap_a, bitmap_c));
+    assert(bitmap_andnot_to(bitmap_c, bitmap_c, bitmap_c));
+    assert(bitmap_ffs(bitmap_c) == SIZE_MAX);
+
+    // 58
+    assert(bitmap_and(bitmap_short, bitmap_b) == false);
+    assert(bitmap_or_to(bitmap_c, bitmap_short, bitmap_b) == false);
+    assert(bitmap_xor_to(bitmap_c, bitmap_b, bitmap_short) == false);
+    assert(bitmap_andnot(NULL, bitmap_b) == false);
+    assert(bitmap_and(bitmap_b, NULL) == false);
+    assert(bitmap_or_to(NULL, bitmap_a, bitmap_b) == false);
+
+    // 59
+    bitmap_format(bitmap_c, 0x00);
+    bitmap_format(bitmap_d, 0x00);
+    assert(bitmap_equal(bitmap_c, bitmap_d));
+    assert(bitmap_intersects(bitmap_c, bitmap_d) == false);
+    bitmap_set(bitmap_d, test_bit_count - 1);
+    assert(bitmap_equal(bitmap_c, bitmap_d) == false);
+    assert(bitmap_intersects(bitmap_c, bitmap_d) == false);
+    bitmap_set(bitmap_c, test_bit_count - 1);
+    assert(bitmap_equal(bitmap_c, bitmap_d));
+    assert(bitmap_intersects(bitmap_c, bitmap_d));
+    bitmap_set(bitmap_c, 3);
+    bitmap_set(bitmap_d, 500);
+    assert(bitmap_equal(bitmap_c, bitmap_d) == false);
+    bitmap_reset(bitmap_c, test_bit_count - 1);
+    assert(bitmap_intersects(bitmap_c, bitmap_d) == false);
+
+    // 60
+    bitmap_t *bitmap_e = bitmap_create(70), *bitmap_f = bitmap_create(70);
+    assert(bitmap_e && bitmap_f);
+    bitmap_e->data[8] = 0xC0;
+    bitmap_f->data[8] = 0x80;
+    assert(bitmap_equal(bitmap_e, bitmap_f));
+    assert(bitmap_intersects(bitmap_e, bitmap_f) == false);
+    bitmap_destroy(bitmap_e);
+    bitmap_destroy(bitmap_f);
+
+    // 61
+    assert(bitmap_equal(bitmap_c, bitmap_short) == false);
+    assert(bitmap_intersects(bitmap_c, bitmap_short) == false);
+    assert(bitmap_equal(NULL, bitmap_c) == false);
+    assert(bitmap_intersects(bitmap_c, NULL) == false);
+
+    bitmap_destroy(bitmap_a);
+    bitmap_destroy(bitmap_b);
+    bitmap_destroy(bitmap_c);
+    bitmap_destroy(bitmap_d);
+    bitmap_destroy(bitmap_short);
+}
+
+size_t for_each_sum = 0;
+
+void for_each_summer(size_t bit_num, void *value) {
+    for_each_sum += bit_num * (*((size_t *)value));
+}
+
+void bitmap_test_j() {
+    const size_t test_bit_count = 300;
+    size_t indices[8], cursor = 0;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    assert(bitmap_a);
+
+    // 63
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 0);
+    assert(cursor == test_bit_count);
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 0);
+
+    // 62
+    bitmap_set(bitmap_a, 0);
+    bitmap_set_range(bitmap_a, 60, 70);
+    bitmap_set(bitmap_a, 127);
+    bitmap_set(bitmap_a, 128);
+    bitmap_set(bitmap_a, 299);
+    cursor = 0;
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 8);
+    assert(indices[0] == 0 && indices[1] == 60 && indices[7] == 66);
+    assert(cursor == 67);
+    assert(bitmap_extract_set(bitmap_a, indices, 3, &cursor) == 3);
+    assert(indices[0] == 67 && indices[2] == 69);
+    assert(cursor == 127);
+    assert(bitmap_extract_set(bitmap_a, indices, 1, &cursor) == 1);
+    assert(indices[0] == 127);
+    assert(cursor == 128);
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 2);
+    assert(indices[0] == 128 && indices[1] == 299);
+    assert(cursor == test_bit_count);
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 0);
+
+    size_t expected = 0, multiplier = 3;
+    cursor = 0;
+    for (size_t count; (count = bitmap_extract_set(bitmap_a, indices, 5, &cursor));) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            expected += indices[idx] * multiplier;
+        }
+    }
+    bitmap_for_each(bitmap_a, &for_each_summer, &multiplier);
+    assert(for_each_sum == expected);
+
+    // 63
+    cursor = 5000;
+    assert(bitmap_extract_set(bitmap_a, indices, 8, &cursor) == 0);
+    assert(cursor == test_bit_count);
+    cursor = 0;
+    assert(bitmap_extract_set(bitmap_a, indices, 0, &cursor) == 0);
+    assert(cursor == 0);
+
+    // 64
+    assert(bitmap_extract_set(NULL, indices, 8, &cursor) == 0);
+    assert(bitmap_extract_set(bitmap_a, NULL, 8, &cursor) == 0);
+    assert(bitmap_extract_set(bitmap_a, indices, 8, NULL) == 0);
+
+    bitmap_destroy(bitmap_a);
+}
+
+void bitmap_test_k() {
+    const size_t test_bit_count = 300;
+    size_t pos = 0, start = 0, length = 0;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    assert(bitmap_a);
+
+    // 66
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length) == false);
+    assert(pos == test_bit_count);
+    pos = 5000;
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length) == false);
+
+    // 65
+    bitmap_set(bitmap_a, 0);
+    bitmap_set(bitmap_a, 2);
+    bitmap_set_range(bitmap_a, 60, 200);
+    bitmap_set_range(bitmap_a, 290, 300);
+    pos = 0;
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 0 && length == 1 && pos == 1);
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 2 && length == 1 && pos == 3);
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 60 && length == 140 && pos == 200);
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 290 && length == 10 && pos == test_bit_count);
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length) == false);
+    pos = 100;
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 100 && length == 100);
+    bitmap_format(bitmap_a, 0xFF);
+    pos = 0;
+    assert(bitmap_next_run(bitmap_a, &pos, &start, &length));
+    assert(start == 0 && length == test_bit_count && pos == test_bit_count);
+
+    // 67
+    pos = 0;
+    assert(bitmap_next_run(NULL, &pos, &start, &length) == false);
+    assert(bitmap_next_run(bitmap_a, NULL, &start, &length) == false);
+    assert(bitmap_next_run(bitmap_a, &pos, NULL, &length) == false);
+    assert(bitmap_next_run(bitmap_a, &pos, &start, NULL) == false);
+
+    bitmap_destroy(bitmap_a);
+}
+
+// Walks the whole bitmap checking rank and select against a running count
+bool bitmap_rank_select_match(const bitmap_t *const bitmap) {
+    size_t total = 0;
+    for (size_t bit = 0; bit < bitmap_get_bits(bitmap); ++bit) {
+        if (bitmap_rank(bitmap, bit) != total) {
+            return false;
+        }
+        if (bitmap_test(bitmap, bit)) {
+            if (bitmap_select(bitmap, total) != bit) {
+                return false;
+            }
+            ++total;
+        }
+    }
+    return bitmap_rank(bitmap, bitmap_get_bits(bitmap)) == total && bitmap_rank(bitmap, SIZE_MAX) == total &&
+           bitmap_select(bitmap, total) == SIZE_MAX && total == bitmap_total_set(bitmap);
+}
+
+void bitmap_test_l() {
+    // A few superblocks and a partial word on the end
+    const size_t test_bit_count = 3000;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_b = bitmap_create(test_bit_count);
+    assert(bitmap_a && bitmap_b);
+    srand(0x0F15);
+    for (size_t idx = 0; idx < 800; ++idx) {
+        const size_t bit = rand() % test_bit_count;
+        bitmap_set(bitmap_a, bit);
+        bitmap_set(bitmap_b, bit);
+    }
+
+    // 68
+    assert(bitmap_rank_select_match(bitmap_a));
+    assert(bitmap_build_rank_index(bitmap_b));
+    assert(bitmap_rank_select_match(bitmap_b));
+    assert(bitmap_select(bitmap_b, 0) == bitmap_ffs(bitmap_b));
+
+    // 69
+    bitmap_set(bitmap_b, 2999);
+    bitmap_reset(bitmap_b, bitmap_ffs(bitmap_b));
+    bitmap_flip(bitmap_b, 1500);
+    assert(bitmap_rank_select_match(bitmap_b));
+    bitmap_set_range(bitmap_b, 100, 1100);
+    assert(bitmap_rank_select_match(bitmap_b));
+    assert(bitmap_rank(bitmap_b, 1100) - bitmap_rank(bitmap_b, 100) == 1000);
+    bitmap_reset_range(bitmap_b, 2000, 3000);
+    assert(bitmap_rank_select_match(bitmap_b));
+    bitmap_invert(bitmap_b);
+    assert(bitmap_rank_select_match(bitmap_b));
+    assert(bitmap_xor(bitmap_b, bitmap_a));
+    assert(bitmap_rank_select_match(bitmap_b));
+    bitmap_format(bitmap_b, 0xFF);
+    assert(bitmap_rank(bitmap_b, 2000) == 2000);
+    assert(bitmap_select(bitmap_b, 2999) == 2999);
+    assert(bitmap_rank_select_match(bitmap_b));
+    assert(bitmap_build_rank_index(bitmap_b));
+    assert(bitmap_rank_select_match(bitmap_b));
+
+    uint8_t raw[13] = {0};
+    bitmap_t *bitmap_c = bitmap_overlay(90, raw + 1);
+    assert(bitmap_c);
+    assert(bitmap_build_rank_index(bitmap_c));
+    bitmap_set(bitmap_c, 89);
+    bitmap_set(bitmap_c, 3);
+    assert(bitmap_rank(bitmap_c, 89) == 1);
+    assert(bitmap_select(bitmap_c, 1) == 89);
+    assert(bitmap_rank_select_match(bitmap_c));
+    bitmap_destroy(bitmap_c);
+
+    // 70
+    assert(bitmap_select(bitmap_a, bitmap_total_set(bitmap_a)) == SIZE_MAX);
+    assert(bitmap_build_rank_index(NULL) == false);
+    assert(bitmap_rank(NULL, 5) == 0);
+    assert(bitmap_select(NULL, 0) == SIZE_MAX);
+
+    bitmap_destroy(bitmap_a);
+    bitmap_destroy(bitmap_b);
+}
+
+// The counted total, checked against counting it the long way
+bool bitmap_count_matches(const bitmap_t *const bitmap) {
+    return bitmap_total_set(bitmap) == bitmap_count_range(bitmap, 0, bitmap_get_bits(bitmap));
+}
+
+void bitmap_test_m() {
+    const size_t test_bit_count = 1000;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_b = bitmap_create(test_bit_count);
+    assert(bitmap_a && bitmap_b);
+    bitmap_set_range(bitmap_b, 300, 700);
+
+    // 71
+    bitmap_set(bitmap_a, 5);
+    assert(bitmap_track_count(bitmap_a));
+    assert(bitmap_total_set(bitmap_a) == 1);
+    bitmap_set(bitmap_a, 5);
+    bitmap_set(bitmap_a, 999);
+    bitmap_reset(bitmap_a, 6);
+    assert(bitmap_total_set(bitmap_a) == 2);
+    bitmap_flip(bitmap_a, 5);
+    bitmap_flip(bitmap_a, 64);
+    assert(bitmap_total_set(bitmap_a) == 2);
+    bitmap_set_range(bitmap_a, 10, 500);
+    assert(bitmap_count_matches(bitmap_a));
+    bitmap_reset_range(bitmap_a, 400, 1000);
+    assert(bitmap_count_matches(bitmap_a));
+    bitmap_format(bitmap_a, 0x5A);
+    assert(bitmap_total_set(bitmap_a) == 500);
+    assert(bitmap_count_matches(bitmap_a));
+    bitmap_invert(bitmap_a);
+    assert(bitmap_total_set(bitmap_a) == 500);
+    bitmap_format(bitmap_a, 0xFF);
+    bitmap_reset(bitmap_a, 0);
+    bitmap_invert(bitmap_a);
+    assert(bitmap_total_set(bitmap_a) == 1);
+    assert(bitmap_or(bitmap_a, bitmap_b));
+    assert(bitmap_total_set(bitmap_a) == 401);
+    assert(bitmap_andnot_to(bitmap_a, bitmap_b, bitmap_b));
+    assert(bitmap_total_set(bitmap_a) == 0);
+    assert(bitmap_test_and_set(bitmap_a, 7) == false);
+    assert(bitmap_test_and_set(bitmap_a, 7) == true);
+    assert(bitmap_ffz_and_claim(bitmap_a, 0) == 0);
+    assert(bitmap_total_set(bitmap_a) == 2);
+    assert(bitmap_test_and_reset(bitmap_a, 7) == true);
+    assert(bitmap_test_and_reset(bitmap_a, 7) == false);
+    assert(bitmap_total_set(bitmap_a) == 1);
+    assert(bitmap_count_matches(bitmap_a));
+
+    // 72
+    uint8_t raw[13] = {0};
+    raw[3] = 0x0F;
+    bitmap_t *bitmap_c = bitmap_overlay(90, raw + 1);
+    assert(bitmap_c);
+    assert(bitmap_track_count(bitmap_c));
+    assert(bitmap_total_set(bitmap_c) == 4);
+    bitmap_set(bitmap_c, 89);
+    bitmap_format(bitmap_c, 0xFF);
+    assert(bitmap_total_set(bitmap_c) == 90);
+    assert(raw[12] == 0xFF);
+    raw[1] = 0x00;
+    assert(bitmap_total_set(bitmap_c) == 90);
+    assert(bitmap_track_count(bitmap_c));
+    assert(bitmap_total_set(bitmap_c) == 82);
+    bitmap_invert(bitmap_c);
+    assert(bitmap_total_set(bitmap_c) == 8);
+    assert(bitmap_count_matches(bitmap_c));
+    bitmap_destroy(bitmap_c);
+
+    // 73
+    assert(bitmap_track_count(NULL) == false);
+
+    bitmap_destroy(bitmap_a);
+    bitmap_destroy(bitmap_b);
+}
+
+void bitmap_test_n() {
+    // Overlay sized, ends mid-word
+    const size_t test_bit_count = 1000;
+    const char *const test_file = "bitmap_map_test.bin";
+    unlink(test_file);
+    struct stat file_stat;
+
+    // 74
+    bitmap_t *bitmap = bitmap_map_file(test_file, test_bit_count, BITMAP_MAP_DEFAULT);
+    assert(bitmap);
+    assert(!stat(test_file, &file_stat) && file_stat.st_size == 125);
+    assert(bitmap_total_set(bitmap) == 0);
+    bitmap_set(bitmap, 0);
+    bitmap_set_range(bitmap, 500, 600);
+    bitmap_set(bitmap, 999);
+    bitmap_destroy(bitmap);
+    bitmap = bitmap_map_file(test_file, test_bit_count, BITMAP_MAP_POPULATE);
+    assert(bitmap);
+    assert(bitmap_track_count(bitmap));
+    assert(bitmap_total_set(bitmap) == 102);
+    assert(bitmap_test(bitmap, 999) && bitmap_ffs_from(bitmap, 1) == 500);
+    bitmap_reset(bitmap, 0);
+    assert(bitmap_sync(bitmap, true));
+    FILE *file = fopen(test_file, "rb");
+    uint8_t raw[125];
+    assert(file && fread(raw, 1, sizeof(raw), file) == sizeof(raw));
+    fclose(file);
+    assert(raw[0] == 0x00 && raw[124] == 0x80 && raw[70] == 0xFF);
+    bitmap_destroy(bitmap);
+
+    // 75
+    bitmap = bitmap_map_file(test_file, 16, BITMAP_MAP_DEFAULT);
+    assert(bitmap);
+    assert(bitmap_count_matches(bitmap) && bitmap_total_set(bitmap) == 0);
+    assert(bitmap_sync(bitmap, false));
+    bitmap_destroy(bitmap);
+    assert(!stat(test_file, &file_stat) && file_stat.st_size == 125);
+    bitmap = bitmap_create(test_bit_count);
+    assert(bitmap_sync(bitmap, true));
+    bitmap_destroy(bitmap);
+
+    // 76
+    assert(bitmap_map_file(NULL, test_bit_count, BITMAP_MAP_DEFAULT) == NULL);
+    assert(bitmap_map_file("no/such/dir/bitmap.bin", test_bit_count, BITMAP_MAP_DEFAULT) == NULL);
+    assert(bitmap_map_file(test_file, 0, BITMAP_MAP_DEFAULT) == NULL);
+    assert(bitmap_sync(NULL, true) == false);
+
+    unlink(test_file);
+}
+
+void bitmap_test_o() {
+    const size_t test_bit_count = 200;
+    bitmap_t *bitmap_a = bitmap_create(test_bit_count);
+    bitmap_t *bitmap_b = bitmap_create(test_bit_count);
+    assert(bitmap_a && bitmap_b);
+
+    // 77
+    for (size_t bit = 0; bit < test_bit_count; bit += 3) {
+        bitmap_inline_set(bitmap_a, bit);
+        bitmap_set(bitmap_b, bit);
+    }
+    bitmap_inline_reset(bitmap_a, 9);
+    bitmap_reset(bitmap_b, 9);
+    bitmap_inline_flip(bitmap_a, 10);
+    bitmap_flip(bitmap_b, 10);
+    assert(bitmap_equal(bitmap_a, bitmap_b));
+    assert(bitmap_inline_test(bitmap_a, 10) && !bitmap_inline_test(bitmap_a, 9));
+    assert(bitmap_inline_word_count(bitmap_a) == 4);
+    for (size_t word = 0; word < 4; ++word) {
+        assert(bitmap_inline_load_word(bitmap_a, word) == bitmap_load_word(bitmap_b, word));
+    }
+    assert(bitmap_load_word(bitmap_a, 0) == 0x9249249249249449);
+    bitmap_inline_store_word(bitmap_a, 1, 0xF0);
+    bitmap_store_word(bitmap_b, 1, 0xF0);
+    assert(bitmap_equal(bitmap_a, bitmap_b));
+    assert(bitmap_ffs_from(bitmap_a, 64) == 68 && bitmap_ffs_from(bitmap_a, 72) == 129);
+
+    uint8_t raw[13] = {0};
+    bitmap_t *bitmap_c = bitmap_overlay(90, raw + 1);
+    assert(bitmap_c);
+    bitmap_inline_store_word(bitmap_c, 1, ~((uint64_t) 0));
+    assert(raw[9] == 0xFF && raw[12] == 0xFF && raw[0] == 0x00);
+    assert(bitmap_inline_load_word(bitmap_c, 1) == 0xFFFFFFFF);
+    bitmap_inline_set(bitmap_c, 8);
+    assert(raw[2] == 0x01 && bitmap_load_word(bitmap_c, 0) == 0x100);
+    bitmap_destroy(bitmap_c);
+
+    // 78
+    assert(bitmap_summarize(bitmap_a));
+    assert(bitmap_track_count(bitmap_a));
+    bitmap_format(bitmap_a, 0xFF);
+    assert(bitmap_ffz(bitmap_a) == SIZE_MAX);
+    bitmap_inline_reset(bitmap_a, 150);
+    assert(bitmap_ffz(bitmap_a) == 150);
+    bitmap_inline_flip(bitmap_a, 150);
+    bitmap_inline_reset(bitmap_a, 199);
+    assert(bitmap_ffz(bitmap_a) == 199 && bitmap_total_set(bitmap_a) == 199);
+    bitmap_inline_store_word(bitmap_a, 0, 0);
+    bitmap_store_word(bitmap_a, 3, ~((uint64_t) 0));
+    assert(bitmap_ffz(bitmap_a) == 0 && bitmap_ffs(bitmap_a) == 64);
+    assert(bitmap_total_set(bitmap_a) == 136);
+    assert(bitmap_count_matches(bitmap_a));
+
+    // 79
+    assert(bitmap_load_word(bitmap_a, 4) == 0);
+    bitmap_store_word(bitmap_a, 4, 1);
+    assert(bitmap_load_word(NULL, 0) == 0);
+    bitmap_store_word(NULL, 0, 1);
+    assert(bitmap_count_matches(bitmap_a));
+
+    bitmap_destroy(bitmap_a);
+    bitmap_destroy(bitmap_b);
+}
+
+// for_each_unordered gets called from several threads at once
+void for_each_unordered_test(size_t bit_num, void *value) {
+    size_t *const totals = (size_t *) value;
+    __atomic_fetch_add(totals, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(totals + 1, bit_num, __ATOMIC_RELAXED);
+}
+
+// Checks everything threaded against the same thing on one thread
+bool bitmap_threads_agree(const bitmap_t *const bitmap, const size_t threads) {
+    size_t serial_start, threaded_start;
+    size_t serial[2] = {0}, threaded[2] = {0};
+    bitmap_set_threads(1);
+    const size_t serial_total = bitmap_total_set(bitmap);
+    const size_t serial_longest = bitmap_longest_zero_run(bitmap, &serial_start);
+    bitmap_for_each(bitmap, &for_each_unordered_test, serial);
+    bitmap_set_threads(threads);
+    if (bitmap_total_set(bitmap) != serial_total || serial[0] != serial_total
+        || bitmap_longest_zero_run(bitmap, &threaded_start) != serial_longest || threaded_start != serial_start) {
+        return false;
+    }
+    bitmap_for_each_unordered(bitmap, &for_each_unordered_test, threaded);
+    if (threaded[0] != serial[0] || threaded[1] != serial[1]) {
+        return false;
+    }
+    const size_t run_lengths[] = {1, 2, 7, 64, 65, 300, 5000};
+    const size_t hints[] = {0, 1, 63, 1000, 9999};
+    for (size_t length = 0; length < sizeof(run_lengths) / sizeof(run_lengths[0]); ++length) {
+        for (size_t hint = 0; hint < sizeof(hints) / sizeof(hints[0]); ++hint) {
+            bitmap_set_threads(1);
+            const size_t expected = bitmap_find_zero_run(bitmap, run_lengths[length], hints[hint]);
+            bitmap_set_threads(threads);
+            if (bitmap_find_zero_run(bitmap, run_lengths[length], hints[hint]) != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void bitmap_test_p() {
+    // A few hundred words, so plenty of chunks
+    const size_t test_bit_count = 20011;
+    bitmap_t *bitmap = bitmap_create(test_bit_count);
+    assert(bitmap);
+    const size_t fills[] = {0, 2, 50, 98, 100};
+    srand(0x0F15);
+
+    // 80
+    for (size_t fill = 0; fill < sizeof(fills) / sizeof(fills[0]); ++fill) {
+        bitmap_format(bitmap, 0x00);
+        for (size_t bit = 0; bit < test_bit_count; ++bit) {
+            if ((size_t) (rand() % 100) < fills[fill]) {
+                bitmap_set(bitmap, bit);
+            }
+        }
+        assert(bitmap_threads_agree(bitmap, 4));
+        assert(bitmap_threads_agree(bitmap, 7));
+    }
+    // Runs that cross several chunks, and one out to the very end
+    bitmap_format(bitmap, 0xFF);
+    bitmap_reset_range(bitmap, 100, 6100);
+    bitmap_reset_range(bitmap, 9000, 15000);
+    bitmap_reset_range(bitmap, 19000, test_bit_count);
+    assert(bitmap_threads_agree(bitmap, 4));
+    size_t run_start;
+    assert(bitmap_longest_zero_run(bitmap, &run_start) == 6000 && run_start == 100);
+    assert(bitmap_find_zero_run(bitmap, 5500, 200) == 200);
+    assert(bitmap_find_zero_run(bitmap, 5950, 200) == 9000);
+    assert(bitmap_find_zero_run(bitmap, 1011, 15000) == 19000);
+    assert(bitmap_find_zero_run(bitmap, 1012, 15000) == SIZE_MAX);
+    bitmap_reset_range(bitmap, 15000, 15001);
+    bitmap_reset_range(bitmap, 15002, 19000);
+    assert(bitmap_longest_zero_run(bitmap, &run_start) == 6001 && run_start == 9000);
+    bitmap_reset(bitmap, 15001);
+    assert(bitmap_longest_zero_run(bitmap, &run_start) == test_bit_count - 9000 && run_start == 9000);
+    assert(bitmap_threads_agree(bitmap, 4));
+
+    // 81
+    size_t totals[2] = {0};
+    bitmap_format(bitmap, 0x00);
+    bitmap_set(bitmap, 5);
+    bitmap_set(bitmap, 20010);
+    bitmap_for_each_unordered(bitmap, &for_each_unordered_test, totals);
+    assert(totals[0] == 2 && totals[1] == 20015);
+    bitmap_t *bitmap_small = bitmap_create(100);
+    assert(bitmap_small);
+    bitmap_set(bitmap_small, 10);
+    bitmap_set(bitmap_small, 20);
+    for_each_counter = 0;
+    size_t offset = 1;
+    bitmap_for_each_unordered(bitmap_small, &for_each_test, &offset);
+    assert(for_each_counter == 32);
+    bitmap_destroy(bitmap_small);
+
+    // 82
+    bitmap_for_each_unordered(NULL, &for_each_unordered_test, totals);
+    bitmap_for_each_unordered(bitmap, NULL, totals);
+    assert(totals[0] == 2);
+
+    bitmap_set_threads(0);
+    bitmap_destroy(bitmap);
+}
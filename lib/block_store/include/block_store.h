@@ -90,11 +90,21 @@ void block_store_destroy(block_store_t *const bs, const bs_flush_flag flush);
 
 ///
 /// Searches for a free block, makes it as in use, and returns the block's id
+///  (next-fit: the search starts after the last allocated block and wraps around)
 /// \param bs BS device
 /// \return Allocated block's id, 0 on error
 ///
 size_t block_store_allocate(block_store_t *const bs);
 
+///
+/// Searches for count free blocks in a row, marks them as in use, and returns the first block's id
+///  (next-fit like allocate, bs_errno is BS_FULL if there's no run that long)
+/// \param bs BS device
+/// \param count The number of contiguous blocks needed
+/// \return First allocated block's id, 0 on error
+///
+size_t block_store_allocate_range(block_store_t *const bs, const size_t count);
+
 ///
 /// Attempts to allocate the requested block id
 /// \param bs the block store object
@@ -110,6 +120,24 @@ bool block_store_request(block_store_t *const bs, const size_t block_id);
 ///
 void block_store_release(block_store_t *const bs, const size_t block_id);
 
+///
+/// Attempts to allocate count blocks starting at the requested block id
+///  Either the whole range is allocated or none of it is (bs_errno is BS_IN_USE if any were taken)
+/// \param bs the block store object
+/// \param block_id the first requested block identifier
+/// \param count the number of blocks to request
+/// \return boolean indicating succes of operation
+///
+bool block_store_request_range(block_store_t *const bs, const size_t block_id, const size_t count);
+
+///
+/// Frees count blocks starting at the specified block
+/// \param bs BS device
+/// \param block_id The first block to free
+/// \param count The number of blocks to free
+///
+void block_store_release_range(block_store_t *const bs, const size_t block_id, const size_t count);
+
 ///
 /// Reads data from the specified block and offset and writes it to the designated buffer
 /// \param bs BS device
@@ -1,4 +1,6 @@
 #include "../include/block_store.h"
+// Inline test/set/reset so the per-block paths don't go through the PLT
+#include <bitmap_inline.h>
 
 // Overriding these will probably break it since I'm not testing it that much
 // It probably won't go crazy so long as the sizes are reasonable and powers of two
@@ -50,6 +52,7 @@ struct block_store {
     bitmap_t *dbm;
     bitmap_t *fbm;
     uint8_t *data_blocks;
+    size_t alloc_cursor; // Next-fit position, allocate searches from here so we don't rescan the full front of the FBM
 };
 // Idea, claim block 8 for "utility" purposes
 //  (or, more accurately, block FBM_BLOCK_COUNT)
@@ -67,7 +70,7 @@ typedef struct {
     bs_status status;
 } bs_sync_obj;
 
-void block_sync(size_t block_id, void *bs_ptr);
+void block_sync(size_t block_id, size_t block_count, void *bs_ptr);
 
 
 
@@ -93,11 +96,12 @@ block_store_t *block_store_create() {
         if ((bs->data_blocks = calloc(BLOCK_SIZE, BLOCK_COUNT)) &&
                 // Eh, calloc, why not (technically a security risk if we don't)
                 (bs->fbm = bitmap_overlay(BLOCK_COUNT, bs->data_blocks)) &&
-                (bs->dbm = bitmap_create(BLOCK_COUNT))) {
-            for (size_t idx = 0; idx < FBM_BLOCK_COUNT; ++idx) {
-                bitmap_set(bs->fbm, idx);
-            }
+                (bs->dbm = bitmap_create(BLOCK_COUNT)) &&
+                // Summary level on the FBM so allocation skips over full stretches quickly
+                bitmap_summarize(bs->fbm)) {
+            bitmap_set_range(bs->fbm, 0, FBM_BLOCK_COUNT);
             bitmap_format(bs->dbm, 0xFF);
+            bs->alloc_cursor = FBM_BLOCK_COUNT;
             // we have never synced, mark all as changed
             bs->flags = DIRTY;
             bs->fd = -1;
@@ -138,10 +142,16 @@ void block_store_destroy(block_store_t *const bs, const bs_flush_flag flush) {
 
 size_t block_store_allocate(block_store_t *const bs) {
     if (bs) {
-        size_t free_block = bitmap_ffz(bs->fbm);
+        // Next-fit. Pick up where the last allocation left off and only wrap around if the back is full
+        // (the FBM blocks are always set, so the wrapped search can start at 0)
+        size_t free_block = bitmap_ffz_from(bs->fbm, bs->alloc_cursor);
+        if (free_block == SIZE_MAX) {
+            free_block = bitmap_ffz(bs->fbm);
+        }
         if (free_block != SIZE_MAX) {
-            bitmap_set(bs->fbm, free_block);
-            bitmap_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(free_block));
+            bs->alloc_cursor = free_block + 1;
+            bitmap_inline_set(bs->fbm, free_block);
+            bitmap_inline_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(free_block));
             // Set that FBM block as changed
             FLAG_SET(bs, DIRTY);
             bs_errno = BS_OK;
@@ -155,11 +165,35 @@ size_t block_store_allocate(block_store_t *const bs) {
 }
 
 
+size_t block_store_allocate_range(block_store_t *const bs, const size_t count) {
+    if (bs && count && count <= DATA_BLOCK_COUNT) {
+        // Same next-fit idea as allocate, but we need count free blocks in a row
+        size_t free_block = bitmap_find_zero_run(bs->fbm, count, bs->alloc_cursor);
+        if (free_block == SIZE_MAX) {
+            free_block = bitmap_find_zero_run(bs->fbm, count, FBM_BLOCK_COUNT);
+        }
+        if (free_block != SIZE_MAX) {
+            bs->alloc_cursor = free_block + count;
+            bitmap_set_range(bs->fbm, free_block, free_block + count);
+            bitmap_set_range(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(free_block),
+                             FBM_BLOCK_CHANGE_LOCATION(free_block + count - 1) + 1);
+            FLAG_SET(bs, DIRTY);
+            bs_errno = BS_OK;
+            return free_block;
+        }
+        bs_errno = BS_FULL;
+        return 0;
+    }
+    bs_errno = BS_PARAM;
+    return 0;
+}
+
+
 bool block_store_request(block_store_t *const bs, const size_t block_id) {
     if (bs && BLOCKID_VALID(block_id)) {
-        if (!bitmap_test(bs->fbm, block_id)) {
-            bitmap_set(bs->fbm, block_id);
-            bitmap_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id));
+        if (!bitmap_inline_test(bs->fbm, block_id)) {
+            bitmap_inline_set(bs->fbm, block_id);
+            bitmap_inline_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id));
             // Set that FBM block as changed
             FLAG_SET(bs, DIRTY);
             bs_errno = BS_OK;
@@ -180,8 +214,41 @@ void block_store_release(block_store_t *const bs, const size_t block_id) {
         // We'll keep it. Could be useful. Doesn't really hurt anything.
         // Keeps it more true to a standard block device.
         // You could also use this function to format the specified block for security reasons
-        bitmap_reset(bs->fbm, block_id);
-        bitmap_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id));
+        bitmap_inline_reset(bs->fbm, block_id);
+        bitmap_inline_set(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id));
+        FLAG_SET(bs, DIRTY);
+        bs_errno = BS_OK;
+        return;
+    }
+    bs_errno = BS_PARAM;
+}
+
+
+bool block_store_request_range(block_store_t *const bs, const size_t block_id, const size_t count) {
+    // All or nothing, so check the whole range before we touch it
+    if (bs && count && BLOCKID_VALID(block_id) && count <= (BLOCK_COUNT - block_id)) {
+        if (!bitmap_test_range_any(bs->fbm, block_id, block_id + count)) {
+            bitmap_set_range(bs->fbm, block_id, block_id + count);
+            bitmap_set_range(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id),
+                             FBM_BLOCK_CHANGE_LOCATION(block_id + count - 1) + 1);
+            FLAG_SET(bs, DIRTY);
+            bs_errno = BS_OK;
+            return true;
+        } else {
+            bs_errno = BS_IN_USE;
+            return false;
+        }
+    }
+    bs_errno = BS_PARAM;
+    return false;
+}
+
+
+void block_store_release_range(block_store_t *const bs, const size_t block_id, const size_t count) {
+    if (bs && count && BLOCKID_VALID(block_id) && count <= (BLOCK_COUNT - block_id)) {
+        bitmap_reset_range(bs->fbm, block_id, block_id + count);
+        bitmap_set_range(bs->dbm, FBM_BLOCK_CHANGE_LOCATION(block_id),
+                         FBM_BLOCK_CHANGE_LOCATION(block_id + count - 1) + 1);
         FLAG_SET(bs, DIRTY);
         bs_errno = BS_OK;
         return;
@@ -194,7 +261,7 @@ size_t block_store_read(const block_store_t *const bs, const size_t block_id, vo
     if (bs && BLOCKID_VALID(block_id) && buffer && nbytes && (nbytes + offset <= BLOCK_SIZE)) {
         // Not going to forbid reading of not-in-use blocks (but we'll log it via the errno)
         memcpy(buffer, bs->data_blocks + BLOCK_OFFSET_POSITION(block_id, offset), nbytes);
-        bs_errno = bitmap_test(bs->fbm, block_id) ? BS_OK : BS_REQUEST_MISMATCH;
+        bs_errno = bitmap_inline_test(bs->fbm, block_id) ? BS_OK : BS_REQUEST_MISMATCH;
         return nbytes;
     }
     // technically we return BS_PARAM even if the internal structure of the BS object is busted
@@ -210,10 +277,10 @@ size_t block_store_read(const block_store_t *const bs, const size_t block_id, vo
 size_t block_store_write(block_store_t *const bs, const size_t block_id, const void *buffer, const size_t nbytes, const size_t offset) {
     if (bs && BLOCKID_VALID(block_id) && buffer && nbytes && (nbytes + offset <= BLOCK_SIZE)) {
         // Not going to forbid writing of not-in-use blocks (but we'll log it via errno)
-        bitmap_set(bs->dbm, block_id);
+        bitmap_inline_set(bs->dbm, block_id);
         FLAG_SET(bs, DIRTY);
         memcpy((void *)(bs->data_blocks + BLOCK_OFFSET_POSITION(block_id, offset)), buffer, nbytes);
-        bs_errno = bitmap_test(bs->fbm, block_id) ? BS_OK : BS_REQUEST_MISMATCH;
+        bs_errno = bitmap_inline_test(bs->fbm, block_id) ? BS_OK : BS_REQUEST_MISMATCH;
         return nbytes;
     }
     bs_errno = BS_PARAM;
@@ -234,6 +301,8 @@ block_store_t *block_store_import(const char *const filename) {
                 if (bs) {
                     if (utility_read_file(fd, bs->data_blocks, BLOCK_COUNT * BLOCK_SIZE) == BLOCK_COUNT * BLOCK_SIZE) {
                         // We're good to go, attempt to link.
+                        // The FBM was just read in underneath the bitmap, bring its summary up to date
+                        bitmap_summarize(bs->fbm);
 
                         close(fd);
                         // manual override because I'm not going to call link
@@ -361,7 +430,12 @@ void block_store_flush(block_store_t *const bs) {
                 */
                 bs_sync_obj sync_results = {0, bs, 0, BS_OK};
 
-                bitmap_for_each(bs->dbm, &block_sync, &sync_results);
+                // One seek and write per run of dirty blocks, stopping at the first failure
+                size_t position = 0, run_start, run_length;
+                while (sync_results.status == BS_OK &&
+                        bitmap_next_run(bs->dbm, &position, &run_start, &run_length)) {
+                    block_sync(run_start, run_length, &sync_results);
+                }
                 if (sync_results.status == BS_OK) {
                     // Well it worked, hopefully
                     // Sipe the DBM and clear the dirty bit
@@ -428,10 +502,10 @@ const bs_status block_store_errno() {
 //
 
 
-// Block sync function to feed to bitmap_for_each
+// Block sync function, flush calls it for each run of dirty blocks
 // Jumps the fd to the needed location and writes to it
 // Admittedly, this function is not pretty.
-void block_sync(size_t block_id, void *bs_sync_ptr) {
+void block_sync(size_t block_id, size_t block_count, void *bs_sync_ptr) {
     bs_sync_obj *bs_sync = (bs_sync_obj *)bs_sync_ptr;
     /*
         typedef struct {
@@ -449,10 +523,10 @@ void block_sync(size_t block_id, void *bs_sync_ptr) {
                     // jump to file position
                     if (lseek(bs_sync->bs->fd, BLOCK_POSITION(block_id), SEEK_SET) == BLOCK_POSITION(block_id)) {
                         // attempt to write
-                        size_t written = utility_write_file(bs_sync->bs->fd, bs_sync->bs->data_blocks + BLOCK_POSITION(block_id), BLOCK_SIZE);
+                        size_t written = utility_write_file(bs_sync->bs->fd, bs_sync->bs->data_blocks + BLOCK_POSITION(block_id), BLOCK_POSITION(block_count));
                         // Update written with WHATEVER happened
                         bs_sync->byte_counter += written;
-                        if (written == BLOCK_SIZE) {
+                        if (written == BLOCK_POSITION(block_count)) {
                             // all is ok, we wrote everything, or so we were told
                             return;
                         }
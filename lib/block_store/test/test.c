@@ -171,6 +171,13 @@ void basic_tests_a() {
     assert(block_store_allocate(bs_a) == ((BLOCK_COUNT >> 3) + 5));
     assert(bs_errno == BS_OK);
 
+    // Allocation is next-fit, so a hole behind the cursor is only reused after a wrap
+    block_store_release(bs_a, FBM_BLOCK_COUNT + 1);
+    block_store_release(bs_a, BLOCK_COUNT - 1);
+    assert(block_store_allocate(bs_a) == BLOCK_COUNT - 1);
+    assert(block_store_allocate(bs_a) == FBM_BLOCK_COUNT + 1);
+    assert(bs_errno == BS_OK);
+
     // Free back to empty
 
     for (size_t i = BLOCK_COUNT; i > FBM_BLOCK_COUNT; --i) {
@@ -209,6 +216,69 @@ void basic_tests_a() {
     block_store_release(NULL, 0);
     assert(bs_errno == BS_PARAM);
 
+    // REQUEST/RELEASE RANGE
+
+    assert(block_store_request_range(bs_a, FBM_BLOCK_COUNT, 32));
+    assert(bs_errno == BS_OK);
+    for (size_t i = FBM_BLOCK_COUNT; i < FBM_BLOCK_COUNT + 32; ++i) {
+        assert(bitmap_test(bs_a->fbm, i));
+    }
+    assert(bitmap_test(bs_a->fbm, FBM_BLOCK_COUNT + 32) == false);
+
+    // overlaps the previous range, nothing should change
+    assert(block_store_request_range(bs_a, FBM_BLOCK_COUNT + 31, 2) == false);
+    assert(bs_errno == BS_IN_USE);
+    assert(bitmap_test(bs_a->fbm, FBM_BLOCK_COUNT + 32) == false);
+
+    assert(block_store_request_range(bs_a, 0, 2) == false);
+    assert(bs_errno == BS_PARAM);
+    assert(block_store_request_range(bs_a, BLOCK_COUNT - 1, 2) == false);
+    assert(bs_errno == BS_PARAM);
+    assert(block_store_request_range(bs_a, FBM_BLOCK_COUNT, 0) == false);
+    assert(bs_errno == BS_PARAM);
+    assert(block_store_request_range(NULL, FBM_BLOCK_COUNT, 1) == false);
+    assert(bs_errno == BS_PARAM);
+
+    block_store_release_range(bs_a, FBM_BLOCK_COUNT, 32);
+    assert(bs_errno == BS_OK);
+    for (size_t i = FBM_BLOCK_COUNT; i < FBM_BLOCK_COUNT + 32; ++i) {
+        assert(bitmap_test(bs_a->fbm, i) == false);
+    }
+    block_store_release_range(bs_a, 0, 1);
+    assert(bs_errno == BS_PARAM);
+    assert(bitmap_test(bs_a->fbm, 0));
+    block_store_release_range(NULL, FBM_BLOCK_COUNT, 1);
+    assert(bs_errno == BS_PARAM);
+
+    // ALLOCATE RANGE
+
+    size_t first_block = block_store_allocate_range(bs_a, 16);
+    assert(bs_errno == BS_OK);
+    assert(first_block >= FBM_BLOCK_COUNT);
+    for (size_t i = first_block; i < first_block + 16; ++i) {
+        assert(bitmap_test(bs_a->fbm, i));
+    }
+    assert(block_store_allocate_range(bs_a, 16) == first_block + 16);
+    block_store_release_range(bs_a, first_block, 32);
+
+    // Only one hole big enough, and it's behind the cursor
+    assert(block_store_request_range(bs_a, FBM_BLOCK_COUNT, DATA_BLOCK_COUNT));
+    block_store_release_range(bs_a, FBM_BLOCK_COUNT + 100, 3);
+    block_store_release_range(bs_a, FBM_BLOCK_COUNT + 200, 8);
+    block_store_release_range(bs_a, BLOCK_COUNT - 2, 2);
+    assert(block_store_allocate_range(bs_a, 4) == FBM_BLOCK_COUNT + 200);
+    assert(bs_errno == BS_OK);
+    assert(block_store_allocate_range(bs_a, 5) == 0);
+    assert(bs_errno == BS_FULL);
+    block_store_release_range(bs_a, FBM_BLOCK_COUNT, DATA_BLOCK_COUNT);
+
+    assert(block_store_allocate_range(bs_a, 0) == 0);
+    assert(bs_errno == BS_PARAM);
+    assert(block_store_allocate_range(bs_a, DATA_BLOCK_COUNT + 1) == 0);
+    assert(bs_errno == BS_PARAM);
+    assert(block_store_allocate_range(NULL, 1) == 0);
+    assert(bs_errno == BS_PARAM);
+
     // ALLOCATE 3
 
     assert(0 == block_store_allocate(NULL));
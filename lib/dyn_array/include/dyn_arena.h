@@ -0,0 +1,52 @@
+#ifndef DYN_ARENA_H__
+#define DYN_ARENA_H__
+
+#include "dyn_array.h"
+
+// Bump allocator, for lots of short-lived allocations that can all go away together
+// Allocating is a pointer bump, freeing anything is a no-op, and reset hands everything back at once.
+// Memory comes in blocks, reset keeps them around, so once an arena has seen its biggest
+// workload it never touches the heap again.
+//
+// Hand dyn_arena_allocator to dyn_array_create_with_allocator and the array lives in the arena too.
+// Just remember the arena doesn't know about destructors, destroy (or clear) the arrays first if they need it.
+
+typedef struct dyn_arena dyn_arena_t;
+
+///
+/// Creates an empty arena
+/// \param block_size Bytes to grab from the heap at a time (0 for the default, 4KB)
+///  Anything bigger than that gets a block of its own
+/// \return new arena pointer, NULL on error
+///
+dyn_arena_t *dyn_arena_create(const size_t block_size);
+
+///
+/// Releases the arena and everything ever allocated from it
+/// \param arena The arena
+///
+void dyn_arena_destroy(dyn_arena_t *arena);
+
+///
+/// Releases everything allocated from the arena in one go (the blocks are kept for reuse)
+/// \param arena The arena
+///
+void dyn_arena_reset(dyn_arena_t *const arena);
+
+///
+/// Allocates memory from the arena, aligned for any type
+/// \param arena The arena
+/// \param size Bytes to allocate
+/// \return pointer to the memory, NULL on error
+///
+void *dyn_arena_alloc(dyn_arena_t *const arena, const size_t size);
+
+///
+/// Gets the allocator hooks for the arena, for dyn_array_create_with_allocator
+/// (reallocating the newest allocation grows it in place, releasing only gives back the newest allocation)
+/// \param arena The arena
+/// \return the allocator, NULL on error
+///
+const dyn_allocator_t *dyn_arena_allocator(const dyn_arena_t *const arena);
+
+#endif
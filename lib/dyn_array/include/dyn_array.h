@@ -8,9 +8,36 @@
 #include <stdint.h>
 
 typedef struct dyn_array dyn_array_t;
-// Next version, push/pop_N_back/front for bulk loading
-// Erase_n
-// etc
+
+// Creation flags
+// DYN_CREATE_RING makes the array a circular buffer, so the front is as cheap as the back
+//  push/pop/extract_front (and the _n versions at index 0) become amortized O(1) instead of moving everything
+//  Inserting or erasing in the middle moves whichever side of it is shorter
+//  Everything else works the same, at/front/back/for_each see the same order
+//  (sort and export may have to straighten the buffer out first, that's O(n))
+// DYN_CREATE_INLINE keeps the first capacity objects in the same allocation as the array itself
+//  Creating it is one allocation instead of two, and small arrays never leave it
+//  Outgrowing it moves everything to the heap, shrinking back down to it (shrink_to_fit) moves it back
+//  Capacity is taken as is (0 for 16) instead of being rounded up, it's what you're paying for up front
+//  Flags can be combined, DYN_CREATE_RING | DYN_CREATE_INLINE is an inline ring
+typedef enum {DYN_CREATE_DEFAULT = 0x00, DYN_CREATE_RING = 0x01, DYN_CREATE_INLINE = 0x02} DYN_CREATE_FLAGS;
+
+// Growth policies, how much capacity to add when an insert runs out (see dyn_array_set_growth)
+// DYN_GROW_FACTOR grows by a percentage of the current capacity (the default, doubling)
+// DYN_GROW_CHUNK grows by a fixed number of objects
+// DYN_GROW_EXACT grows by exactly what's needed (a realloc on every insert that doesn't fit, reserve first!)
+typedef enum {DYN_GROW_FACTOR = 0x00, DYN_GROW_CHUNK = 0x01, DYN_GROW_EXACT = 0x02} DYN_GROWTH_POLICY;
+
+// Allocator hooks, for when malloc/realloc/free aren't what you want (see dyn_arena.h for an arena)
+// Every call gets context back, and the size of what's being (re)allocated/released
+//  allocate and reallocate act like malloc and realloc, NULL on failure
+//  release may be NULL, for allocators that get everything back at once
+typedef struct {
+    void *(*allocate)(void *context, const size_t size);
+    void *(*reallocate)(void *context, void *pointer, const size_t old_size, const size_t new_size);
+    void (*release)(void *context, void *pointer, const size_t size);
+    void *context;
+} dyn_allocator_t;
 
 /*
 	Destructor notes!
@@ -40,6 +67,30 @@ typedef struct dyn_array dyn_array_t;
 ///
 dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *));
 
+///
+/// Creates a new dynamic array, same as dyn_array_create, with creation flags
+/// \param capacity Minimum capacity request (0 is fine if you have no opinion)
+/// \param data_type_size Size of the object type to be stored in bytes
+/// \param destruct_func Optional destructor to be applied on destruct operations (NULL to disable)
+/// \param flags DYN_CREATE_FLAGS to apply (DYN_CREATE_DEFAULT for a plain array)
+/// \return new dynamic array pointer, NULL on error
+///
+dyn_array_t *dyn_array_create_flags(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                    const DYN_CREATE_FLAGS flags);
+
+///
+/// Creates a new dynamic array, same as dyn_array_create_flags, that gets all of its memory
+/// (the array itself included) from the given allocator
+/// \param capacity Minimum capacity request (0 is fine if you have no opinion)
+/// \param data_type_size Size of the object type to be stored in bytes
+/// \param destruct_func Optional destructor to be applied on destruct operations (NULL to disable)
+/// \param flags DYN_CREATE_FLAGS to apply (DYN_CREATE_DEFAULT for a plain array)
+/// \param allocator The allocator to use (copied), NULL for malloc/realloc/free
+/// \return new dynamic array pointer, NULL on error (including an allocator missing allocate or reallocate)
+///
+dyn_array_t *dyn_array_create_with_allocator(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                             const DYN_CREATE_FLAGS flags, const dyn_allocator_t *const allocator);
+
 ///
 /// Creates a new dynamic array from a given array
 /// (Given pointer can be freed after import, we copy the data)
@@ -54,6 +105,7 @@ dyn_array_t *dyn_array_import(const void *const data, const size_t count, const
 ///
 /// Returns an internal pointer to the data array for export
 /// Since this pointer is internal, it may be invalidated by insertions that trigger reallocation
+/// (or, for DYN_CREATE_RING arrays, by any insertion or removal at the front)
 /// \param dyn_array The dynamic array to export
 /// \return Pointer to dynamic array contents, NULL on error
 ///
@@ -182,6 +234,59 @@ bool dyn_array_extract(dyn_array_t *const dyn_array, const size_t index,
                            void *const object);
 
 
+// Bulk versions of the above, count objects at a time for the price of one move
+// (count must be non-zero, same as it always was internally)
+
+///
+/// Inserts count objects from the given array at the given index, increasing the container size by count
+/// and moving any contents at index and beyond down count
+/// \param dyn_array the dynamic array
+/// \param index the position to insert the objects at
+/// \param objects the objects to insert (a plain array of count objects)
+/// \param count the number of objects
+/// \return bool representing success of the operation
+///
+bool dyn_array_insert_n(dyn_array_t *const dyn_array, const size_t index, const void *const objects, const size_t count);
+
+///
+/// Removes and optionally destructs count objects starting at the given index
+/// \param dyn_array the dynamic array
+/// \param index index of the first object to be erased
+/// \param count the number of objects
+/// \return bool representing success of the operation (false if the range runs past the end)
+///
+bool dyn_array_erase_n(dyn_array_t *const dyn_array, const size_t index, const size_t count);
+
+///
+/// Removes count objects starting at the given index and places them at the desired location
+/// Does not destruct the objects since they are returned to the user
+/// \param dyn_array the dynamic array
+/// \param index the index of the first object to extract
+/// \param count the number of objects
+/// \param objects destination for the extracted objects (room for count of them)
+/// \return bool representing success of the operation (false if the range runs past the end)
+///
+bool dyn_array_extract_n(dyn_array_t *const dyn_array, const size_t index, const size_t count, void *const objects);
+
+///
+/// Copies count objects from the given array onto the back of the array
+/// \param dyn_array the dynamic array
+/// \param objects the objects to insert (a plain array of count objects)
+/// \param count the number of objects
+/// \return bool representing success of the operation
+///
+bool dyn_array_push_back_n(dyn_array_t *const dyn_array, const void *const objects, const size_t count);
+
+///
+/// Copies the contents of src onto the back of dst (src is left alone, and may be dst)
+/// The copies are byte copies, so if src has a destructor, be careful who ends up destructing what
+/// \param dst the dynamic array to append to
+/// \param src the dynamic array to copy from, must hold the same size objects
+/// \return bool representing success of the operation (appending an empty array succeeds)
+///
+bool dyn_array_append(dyn_array_t *const dst, const dyn_array_t *const src);
+
+
 ///
 /// Removes and optionally destructs all array elements
 /// \param dyn_array the dynamic array
@@ -216,6 +321,35 @@ size_t dyn_array_capacity(const dyn_array_t *const dyn_array);
 ///
 size_t dyn_array_data_size(const dyn_array_t *const dyn_array);
 
+///
+/// Makes sure the array can hold at least capacity objects without reallocating
+/// Capacity is set to exactly that (no rounding up), and is never reduced
+/// \param dyn_array the dynamic array
+/// \param capacity the number of objects to make room for
+/// \return bool representing success of the operation
+///
+bool dyn_array_reserve(dyn_array_t *const dyn_array, const size_t capacity);
+
+///
+/// Reduces the capacity to the current size (an empty array keeps room for one object)
+/// DYN_CREATE_INLINE arrays never go below their inline capacity, they move back inline instead
+/// The next insert will have to grow it again, so call this once the array has settled
+/// \param dyn_array the dynamic array
+/// \return bool representing success of the operation (the array is untouched on failure)
+///
+bool dyn_array_shrink_to_fit(dyn_array_t *const dyn_array);
+
+///
+/// Sets how the array grows when an insert runs out of capacity
+/// \param dyn_array the dynamic array
+/// \param policy the DYN_GROWTH_POLICY to use
+/// \param amount DYN_GROW_FACTOR: percent to grow by (1 - 1000, 100 doubles, the default)
+///               DYN_GROW_CHUNK: objects to grow by (at least 1)
+///               DYN_GROW_EXACT: unused
+/// \return bool representing success of the operation (nothing changes on failure)
+///
+bool dyn_array_set_growth(dyn_array_t *const dyn_array, const DYN_GROWTH_POLICY policy, const size_t amount);
+
 ///
 /// Sorts the array according to the given comparator function
 /// compare(x,y) < 0 iff x < y
@@ -233,6 +367,7 @@ bool dyn_array_sort(dyn_array_t *const dyn_array, int (*compare)(const void *, c
 /// Inserts the given object into the correct sorted position
 ///  increasing the container size by one
 /// and moving any contents beyond the sorted position down one
+/// The position is found by binary search, and the object goes in front of any equal ones
 /// Note: calling this on an unsorted array will insert it... somewhere
 /// \param dyn_array the dynamic array
 /// \param object the object to insert
@@ -242,6 +377,54 @@ bool dyn_array_sort(dyn_array_t *const dyn_array, int (*compare)(const void *, c
 bool dyn_array_insert_sorted(dyn_array_t *const dyn_array, const void *const object,
                                  int (*compare)(const void *const, const void *const));
 
+// The sorted searches below all binary search, so the array has to be sorted by the same comparator
+// The comparator is always called as compare(object, array_object)
+
+///
+/// Finds the first position whose object is not less than the given object
+///  (where insert_sorted would put it)
+/// \param dyn_array the dynamic array
+/// \param object the object to search for
+/// \param compare the comparison function
+/// \return the position (size if everything is less), SIZE_MAX on error
+///
+size_t dyn_array_lower_bound(const dyn_array_t *const dyn_array, const void *const object,
+                             int (*compare)(const void *const, const void *const));
+
+///
+/// Finds the first position whose object is greater than the given object
+/// \param dyn_array the dynamic array
+/// \param object the object to search for
+/// \param compare the comparison function
+/// \return the position (size if nothing is greater), SIZE_MAX on error
+///
+size_t dyn_array_upper_bound(const dyn_array_t *const dyn_array, const void *const object,
+                             int (*compare)(const void *const, const void *const));
+
+///
+/// Finds an object equal to the given object (the first one, if there are several)
+/// Pointer may be invalidated if the container increases in size
+/// \param dyn_array the dynamic array
+/// \param object the object to search for
+/// \param compare the comparison function
+/// \return pointer to the matching object, NULL on error/not found
+///
+void *dyn_array_bsearch(const dyn_array_t *const dyn_array, const void *const object,
+                        int (*compare)(const void *const, const void *const));
+
+///
+/// Finds the range of objects equal to the given object, [first, last)
+///  (first == last if there aren't any, that's where one would go)
+/// \param dyn_array the dynamic array
+/// \param object the object to search for
+/// \param compare the comparison function
+/// \param first destination for the first position of the range
+/// \param last destination for the position after the range
+/// \return bool representing success of the operation
+///
+bool dyn_array_equal_range(const dyn_array_t *const dyn_array, const void *const object,
+                           int (*compare)(const void *const, const void *const), size_t *const first, size_t *const last);
+
 ///
 /// Applies the given function to every object in the array
 /// \param dyn_array the dynamic array
@@ -250,6 +433,29 @@ bool dyn_array_insert_sorted(dyn_array_t *const dyn_array, const void *const obj
 ///
 bool dyn_array_for_each(dyn_array_t *const dyn_array, void (*func)(void *const));
 
+///
+/// Removes (and destructs) every object the predicate is true for, in one pass
+/// The objects left keep their order. The predicate must not modify the array.
+/// \param dyn_array the dynamic array
+/// \param predicate returns true for objects to remove, gets the object and context
+/// \param context passed on to the predicate (may be NULL)
+/// \return the number of objects removed, 0 on error
+///
+size_t dyn_array_remove_if(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                           void *const context);
+
+///
+/// Reorders the array so every object the predicate is true for comes before every object it's false for
+/// Faster than remove_if, but the order within each group isn't kept (nothing is destructed either)
+/// Partition by what you want to keep then erase_n from the returned index on for an unordered remove_if
+/// \param dyn_array the dynamic array
+/// \param predicate the test to partition by, gets the object and context
+/// \param context passed on to the predicate (may be NULL)
+/// \return the number of objects the predicate is true for (the index of the first false one), 0 on error
+///
+size_t dyn_array_partition(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                           void *const context);
+
 bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increment);
 
 #endif
@@ -0,0 +1,229 @@
+#ifndef DYN_ARRAY_TYPED_H__
+#define DYN_ARRAY_TYPED_H__
+
+#include "dyn_array.h"
+
+#include <string.h>
+
+// Opt-in typed versions of the hot path, generated per type with DYN_ARRAY_DEFINE
+// The generic API works in bytes: every access multiplies by data_size, every copy is a memcpy
+// of unknown length, and every comparison goes through a function pointer. The generated functions
+// know the type, so those become plain indexing, assignment, and comparisons the compiler can inline.
+//
+//  DYN_ARRAY_DEFINE_ACCESS(name, type)       name_create, name_at/front/back, name_push/pop/extract_front/back
+//  DYN_ARRAY_DEFINE_SORTED(name, type, cmp)  name_sort, name_lower_bound, name_bsearch
+//  DYN_ARRAY_DEFINE(name, type, cmp)         both of the above
+//
+// cmp is called as cmp(const type *, const type *) and follows the same rules as the generic comparators.
+// It can be a function (static inline, or defined in the same file, if you want it inlined) or a macro.
+//
+// The generated functions take the same dyn_array_t as everything else, so the two APIs mix freely.
+// The array has to hold type (name_create makes sure of that). Like bitmap_inline.h, there are no NULL checks,
+// and the struct layout is out in the open: the library is built from this definition, so they always agree,
+// but code compiled against one version's layout has to run with that version's library.
+// Anything that isn't a simple case (growing, destructors, the front of a plain array) goes out of line
+// to the real functions.
+
+struct dyn_array {
+    unsigned flags; // DYN_FLAGS, see dyn_array.c
+    size_t capacity;
+    size_t size;
+    size_t data_size;
+    // Slot holding index 0, indices past the end of the buffer wrap around to the start
+    // Always 0 unless RING, so plain arrays never wrap
+    size_t head;
+    // How dyn_request_size_increase picks the new capacity, see dyn_array_set_growth
+    DYN_GROWTH_POLICY growth;
+    size_t growth_amount;
+    // Where the struct and the array come from (malloc and friends unless told otherwise)
+    dyn_allocator_t allocator;
+    // Objects that fit in the storage after the struct (DYN_CREATE_INLINE), 0 if there is none
+    size_t inline_capacity;
+    void *array;
+    void (*destructor)(void *);
+};
+
+// The RING flag (DYN_CREATE_RING), the only one the typed functions care about
+#define DYN_TYPED_RING 0x01
+
+// The object at index idx in an array of type, no range check (the ring wrap is dealt with)
+#define DYN_TYPED_AT(type, dyn_array_ptr, idx) (((type *) (dyn_array_ptr)->array) + \
+    (((dyn_array_ptr)->head + (idx)) >= (dyn_array_ptr)->capacity ? \
+     ((dyn_array_ptr)->head + (idx)) - (dyn_array_ptr)->capacity : (dyn_array_ptr)->head + (idx)))
+
+// Runs shorter than this get insertion sorted before merging
+#define DYN_TYPED_SORT_RUN 16
+
+#define DYN_ARRAY_DEFINE(name, type, cmp) \
+    DYN_ARRAY_DEFINE_ACCESS(name, type) \
+    DYN_ARRAY_DEFINE_SORTED(name, type, cmp)
+
+#define DYN_ARRAY_DEFINE_ACCESS(name, type) \
+    /* Creates a new dynamic array of type, see dyn_array_create_flags */ \
+    static inline dyn_array_t *name##_create(const size_t capacity, void (*destruct_func)(void *), \
+                                             const DYN_CREATE_FLAGS flags) { \
+        return dyn_array_create_flags(capacity, sizeof(type), destruct_func, flags); \
+    } \
+    \
+    /* Returns a pointer to the object at index, NULL if it's out of range */ \
+    static inline type *name##_at(const dyn_array_t *const dyn_array, const size_t index) { \
+        return index < dyn_array->size ? DYN_TYPED_AT(type, dyn_array, index) : NULL; \
+    } \
+    \
+    /* Returns a pointer to the first object, NULL if empty */ \
+    static inline type *name##_front(const dyn_array_t *const dyn_array) { \
+        return dyn_array->size ? ((type *) dyn_array->array) + dyn_array->head : NULL; \
+    } \
+    \
+    /* Returns a pointer to the last object, NULL if empty */ \
+    static inline type *name##_back(const dyn_array_t *const dyn_array) { \
+        return dyn_array->size ? DYN_TYPED_AT(type, dyn_array, dyn_array->size - 1) : NULL; \
+    } \
+    \
+    /* Adds object to the back, see dyn_array_push_back */ \
+    static inline bool name##_push_back(dyn_array_t *const dyn_array, const type object) { \
+        if (dyn_array->size < dyn_array->capacity) { \
+            *DYN_TYPED_AT(type, dyn_array, dyn_array->size) = object; \
+            ++dyn_array->size; \
+            return true; \
+        } \
+        return dyn_array_push_back(dyn_array, &object); \
+    } \
+    \
+    /* Adds object to the front, see dyn_array_push_front */ \
+    static inline bool name##_push_front(dyn_array_t *const dyn_array, const type object) { \
+        if ((dyn_array->flags & DYN_TYPED_RING) && dyn_array->size < dyn_array->capacity) { \
+            dyn_array->head = (dyn_array->head ? dyn_array->head : dyn_array->capacity) - 1; \
+            ((type *) dyn_array->array)[dyn_array->head] = object; \
+            ++dyn_array->size; \
+            return true; \
+        } \
+        return dyn_array_push_front(dyn_array, &object); \
+    } \
+    \
+    /* Copies the last object to object and removes it without destructing it, see dyn_array_extract_back */ \
+    static inline bool name##_extract_back(dyn_array_t *const dyn_array, type *const object) { \
+        if (dyn_array->size) { \
+            *object = *DYN_TYPED_AT(type, dyn_array, dyn_array->size - 1); \
+            if (!--dyn_array->size) { \
+                dyn_array->head = 0; \
+            } \
+            return true; \
+        } \
+        return false; \
+    } \
+    \
+    /* Copies the first object to object and removes it without destructing it, see dyn_array_extract_front */ \
+    static inline bool name##_extract_front(dyn_array_t *const dyn_array, type *const object) { \
+        if ((dyn_array->flags & DYN_TYPED_RING) && dyn_array->size) { \
+            *object = ((type *) dyn_array->array)[dyn_array->head]; \
+            dyn_array->head = (--dyn_array->size) ? \
+                              (dyn_array->head + 1 == dyn_array->capacity ? 0 : dyn_array->head + 1) : 0; \
+            return true; \
+        } \
+        return dyn_array_extract_front(dyn_array, object); \
+    } \
+    \
+    /* Removes and destructs the last object, see dyn_array_pop_back */ \
+    static inline bool name##_pop_back(dyn_array_t *const dyn_array) { \
+        type object; \
+        return dyn_array->destructor ? dyn_array_pop_back(dyn_array) : name##_extract_back(dyn_array, &object); \
+    } \
+    \
+    /* Removes and destructs the first object, see dyn_array_pop_front */ \
+    static inline bool name##_pop_front(dyn_array_t *const dyn_array) { \
+        type object; \
+        return dyn_array->destructor ? dyn_array_pop_front(dyn_array) : name##_extract_front(dyn_array, &object); \
+    }
+
+#define DYN_ARRAY_DEFINE_SORTED(name, type, cmp) \
+    /* Stable insertion sort of count objects, for the short runs */ \
+    static inline void name##_sort_run(type *const data, const size_t count) { \
+        for (size_t idx = 1; idx < count; ++idx) { \
+            const type object = data[idx]; \
+            size_t pos = idx; \
+            for (; pos && cmp(&data[pos - 1], &object) > 0; --pos) { \
+                data[pos] = data[pos - 1]; \
+            } \
+            data[pos] = object; \
+        } \
+    } \
+    \
+    /* Merges the sorted runs [0, middle) and [middle, count) of from into to, ties go to the first run */ \
+    static inline void name##_sort_merge(const type *const from, type *const to, const size_t middle, \
+                                         const size_t count) { \
+        size_t left = 0, right = middle, out = 0; \
+        while (left < middle && right < count) { \
+            to[out++] = (cmp(&from[right], &from[left]) < 0) ? from[right++] : from[left++]; \
+        } \
+        while (left < middle) { \
+            to[out++] = from[left++]; \
+        } \
+        while (right < count) { \
+            to[out++] = from[right++]; \
+        } \
+    } \
+    \
+    /* Sorts the array with cmp, see dyn_array_sort. Unlike that one, this sort is stable. */ \
+    /* Merge sort, without the scratch space (if there's no memory for it) it's an insertion sort */ \
+    /* The scratch space comes from the array's allocator, like everything else it uses */ \
+    static inline bool name##_sort(dyn_array_t *const dyn_array) { \
+        const size_t count = dyn_array->size; \
+        if (count < 2) { \
+            return count == 1; \
+        } \
+        /* Lines a ring up so it's one run of memory */ \
+        type *data = (type *) dyn_array_export(dyn_array); \
+        type *scratch = (count > DYN_TYPED_SORT_RUN) ? \
+                        (type *) dyn_array->allocator.allocate(dyn_array->allocator.context, count * sizeof(type)) : NULL; \
+        if (!scratch) { \
+            name##_sort_run(data, count); \
+            return true; \
+        } \
+        for (size_t start = 0; start < count; start += DYN_TYPED_SORT_RUN) { \
+            name##_sort_run(data + start, \
+                            (count - start < DYN_TYPED_SORT_RUN) ? count - start : DYN_TYPED_SORT_RUN); \
+        } \
+        /* Bottom up, going back and forth between the array and the scratch space */ \
+        type *from = data, *to = scratch; \
+        for (size_t width = DYN_TYPED_SORT_RUN; width < count; width <<= 1) { \
+            for (size_t start = 0; start < count; start += width << 1) { \
+                const size_t middle = (count - start < width) ? count - start : width; \
+                const size_t end = (count - start < (width << 1)) ? count - start : (width << 1); \
+                name##_sort_merge(from + start, to + start, middle, end); \
+            } \
+            type *const temp = from; \
+            from = to; \
+            to = temp; \
+        } \
+        if (from != data) { \
+            memcpy(data, from, count * sizeof(type)); \
+        } \
+        if (dyn_array->allocator.release) { \
+            dyn_array->allocator.release(dyn_array->allocator.context, scratch, count * sizeof(type)); \
+        } \
+        return true; \
+    } \
+    \
+    /* Finds the first position whose object is not less than object, see dyn_array_lower_bound */ \
+    static inline size_t name##_lower_bound(const dyn_array_t *const dyn_array, const type *const object) { \
+        size_t low = 0, high = dyn_array->size; \
+        while (low < high) { \
+            const size_t middle = low + ((high - low) >> 1); \
+            if (cmp(object, DYN_TYPED_AT(type, dyn_array, middle)) > 0) { \
+                low = middle + 1; \
+            } else { \
+                high = middle; \
+            } \
+        } \
+        return low; \
+    } \
+    \
+    /* Finds the first object equal to object, NULL if there isn't one, see dyn_array_bsearch */ \
+    static inline type *name##_bsearch(const dyn_array_t *const dyn_array, const type *const object) { \
+        const size_t position = name##_lower_bound(dyn_array, object); \
+        return (position < dyn_array->size && cmp(object, DYN_TYPED_AT(type, dyn_array, position)) == 0) \
+               ? DYN_TYPED_AT(type, dyn_array, position) : NULL; \
+    }
+
+#endif
@@ -0,0 +1,163 @@
+#include "../include/dyn_arena.h"
+
+// Everything handed out is rounded to this, it's what malloc guarantees on everything we care about
+#define DYN_ARENA_ALIGN 16
+#define DYN_ARENA_ROUND(size) (((size) + (DYN_ARENA_ALIGN - 1)) & ~((size_t) (DYN_ARENA_ALIGN - 1)))
+#define DYN_ARENA_DEFAULT_BLOCK 4096
+
+typedef struct dyn_arena_block {
+    struct dyn_arena_block *next;
+    size_t size, used; // bytes of data, and how many of them are handed out
+} dyn_arena_block_t;
+
+// The data goes right after the header (rounded so it stays aligned)
+#define DYN_ARENA_HEADER DYN_ARENA_ROUND(sizeof(dyn_arena_block_t))
+#define DYN_ARENA_DATA(block) (((uint8_t *) (block)) + DYN_ARENA_HEADER)
+
+struct dyn_arena {
+    // Blocks in the order they get used, current is the one being bumped
+    // Anything after current is empty (left over from before a reset)
+    dyn_arena_block_t *first, *current;
+    size_t block_size;
+    // The newest allocation, the only one reallocate can grow and release can take back
+    uint8_t *last;
+    dyn_allocator_t allocator;
+};
+
+// The hooks behind dyn_arena_allocator
+void *dyn_arena_allocate_hook(void *context, const size_t size);
+void *dyn_arena_reallocate_hook(void *context, void *pointer, const size_t old_size, const size_t new_size);
+void dyn_arena_release_hook(void *context, void *pointer, const size_t size);
+
+// Adds a block with room for at least size bytes after current
+dyn_arena_block_t *dyn_arena_add_block(dyn_arena_t *const arena, const size_t size);
+
+dyn_arena_t *dyn_arena_create(const size_t block_size) {
+    if (block_size <= SIZE_MAX - DYN_ARENA_HEADER - DYN_ARENA_ALIGN) {
+        dyn_arena_t *arena = (dyn_arena_t *) malloc(sizeof(dyn_arena_t));
+        if (arena) {
+            arena->first = arena->current = NULL;
+            arena->block_size = DYN_ARENA_ROUND(block_size ? block_size : DYN_ARENA_DEFAULT_BLOCK);
+            arena->last = NULL;
+            arena->allocator.allocate = &dyn_arena_allocate_hook;
+            arena->allocator.reallocate = &dyn_arena_reallocate_hook;
+            arena->allocator.release = &dyn_arena_release_hook;
+            arena->allocator.context = arena;
+            // Grab the first block now, so a fresh arena is ready to go without touching the heap
+            if (dyn_arena_add_block(arena, arena->block_size)) {
+                return arena;
+            }
+            free(arena);
+        }
+    }
+    return NULL;
+}
+
+void dyn_arena_destroy(dyn_arena_t *arena) {
+    if (arena) {
+        dyn_arena_block_t *block = arena->first;
+        while (block) {
+            dyn_arena_block_t *next = block->next;
+            free(block);
+            block = next;
+        }
+        free(arena);
+    }
+}
+
+void dyn_arena_reset(dyn_arena_t *const arena) {
+    if (arena) {
+        for (dyn_arena_block_t *block = arena->first; block; block = block->next) {
+            block->used = 0;
+        }
+        arena->current = arena->first;
+        arena->last = NULL;
+    }
+}
+
+void *dyn_arena_alloc(dyn_arena_t *const arena, const size_t size) {
+    if (arena && size && size <= SIZE_MAX - DYN_ARENA_HEADER - DYN_ARENA_ALIGN) {
+        const size_t rounded = DYN_ARENA_ROUND(size);
+        // Whatever's left in current, then the empty blocks after it, then a new one
+        // (blocks skipped over sit there unused until the next reset)
+        dyn_arena_block_t *block = arena->current;
+        while (block && block->size - block->used < rounded) {
+            block = block->next;
+        }
+        if (!block) {
+            block = dyn_arena_add_block(arena, rounded);
+        }
+        if (block) {
+            arena->current = block;
+            arena->last = DYN_ARENA_DATA(block) + block->used;
+            block->used += rounded;
+            return arena->last;
+        }
+    }
+    return NULL;
+}
+
+const dyn_allocator_t *dyn_arena_allocator(const dyn_arena_t *const arena) {
+    return arena ? &arena->allocator : NULL;
+}
+
+
+//
+///
+// HERE BE DRAGONS
+///
+//
+
+
+dyn_arena_block_t *dyn_arena_add_block(dyn_arena_t *const arena, const size_t size) {
+    const size_t data_size = size > arena->block_size ? size : arena->block_size;
+    dyn_arena_block_t *block = (dyn_arena_block_t *) malloc(DYN_ARENA_HEADER + data_size);
+    if (block) {
+        block->size = data_size;
+        block->used = 0;
+        if (arena->current) {
+            // After current, so the empty ones after it are still up next
+            block->next = arena->current->next;
+            arena->current->next = block;
+        } else {
+            block->next = NULL;
+            arena->first = block;
+        }
+        arena->current = block;
+    }
+    return block;
+}
+
+void *dyn_arena_allocate_hook(void *context, const size_t size) {
+    return dyn_arena_alloc((dyn_arena_t *) context, size);
+}
+
+void *dyn_arena_reallocate_hook(void *context, void *pointer, const size_t old_size, const size_t new_size) {
+    dyn_arena_t *arena = (dyn_arena_t *) context;
+    if (!pointer) {
+        return dyn_arena_alloc(arena, new_size);
+    }
+    if (pointer == arena->last) {
+        // The newest allocation just moves the bump pointer, if the block has room
+        const size_t offset = arena->last - DYN_ARENA_DATA(arena->current);
+        if (new_size <= arena->current->size - offset) {
+            arena->current->used = offset + DYN_ARENA_ROUND(new_size);
+            return pointer;
+        }
+    }
+    // Anything else gets copied somewhere new, the old spot is wasted until the next reset
+    void *new_pointer = dyn_arena_alloc(arena, new_size);
+    if (new_pointer) {
+        memcpy(new_pointer, pointer, old_size < new_size ? old_size : new_size);
+    }
+    return new_pointer;
+}
+
+void dyn_arena_release_hook(void *context, void *pointer, const size_t size) {
+    dyn_arena_t *arena = (dyn_arena_t *) context;
+    if (pointer && pointer == arena->last) {
+        // The newest one can be taken back, everything else waits for reset
+        arena->current->used = arena->last - DYN_ARENA_DATA(arena->current);
+        arena->last = NULL;
+    }
+}
@@ -1,19 +1,13 @@
 #include "../include/dyn_array.h"
+#include "../include/dyn_array_typed.h"
 
 // Flag values
-// SHRUNK to indicate shrink_to_fit was called and size needs to be rehandled
+// RING for DYN_CREATE_RING, front operations move head instead of the contents
 // SORTED to track if the objects have been sorted by us (sorted is set by sort and unset by insert/push)
-// these are just ideas
-//typedef enum {NONE = 0x00, SHRUNK = 0x01, SORTED = 0x02, ALL = 0xFF} DYN_FLAGS;
-
-struct dyn_array {
-    // DYN_FLAGS flags;
-    size_t capacity;
-    size_t size;
-    size_t data_size;
-    void *array;
-    void (*destructor)(void *);
-};
+// (that last one is still just an idea)
+typedef enum {NONE = 0x00, RING = DYN_TYPED_RING, ALL = 0xFF} DYN_FLAGS;
+
+// struct dyn_array lives in dyn_array_typed.h, the typed functions need the layout
 
 // Supports 64bit+ size_t!
 // Semi-arbitrary cap on contents. We'll run out of memory before this happens anyway.
@@ -26,6 +20,22 @@ struct dyn_array {
 #define DYN_ARRAY_POSITION(dyn_array_ptr, idx) (((uint8_t*)dyn_array_ptr->array) + ((idx) * dyn_array_ptr->data_size))
 // Gets the size (in bytes) of n dyn_array elements
 #define DYN_SIZE_N_ELEMS(dyn_array_ptr, n) (dyn_array_ptr->data_size * (n))
+// Slot in the buffer holding index idx (idx <= capacity)
+#define DYN_RING_SLOT(dyn_array_ptr, idx) ((dyn_array_ptr->head + (idx)) >= dyn_array_ptr->capacity ? \
+                                           (dyn_array_ptr->head + (idx)) - dyn_array_ptr->capacity : dyn_array_ptr->head + (idx))
+// Like DYN_ARRAY_POSITION, but takes an index instead of a slot
+#define DYN_ARRAY_AT(dyn_array_ptr, idx) DYN_ARRAY_POSITION(dyn_array_ptr, DYN_RING_SLOT(dyn_array_ptr, idx))
+// Inline storage starts after the struct, rounded up so it's as aligned as anything malloc hands out
+#define DYN_INLINE_OFFSET ((sizeof(dyn_array_t) + 15) & ~((size_t) 15))
+#define DYN_INLINE_STORAGE(dyn_array_ptr) (((uint8_t*)dyn_array_ptr) + DYN_INLINE_OFFSET)
+// Whether the objects are in the inline storage right now (checking inline_capacity first,
+// since an allocator like the arena could hand out an array right where the storage would be)
+#define DYN_IS_INLINE(dyn_array_ptr) (dyn_array_ptr->inline_capacity && \
+                                      dyn_array_ptr->array == DYN_INLINE_STORAGE(dyn_array_ptr))
+// Bytes in the allocation holding the struct (and inline storage)
+#define DYN_STRUCT_BYTES(dyn_array_ptr) (dyn_array_ptr->inline_capacity ? \
+                                         DYN_INLINE_OFFSET + DYN_SIZE_N_ELEMS(dyn_array_ptr, dyn_array_ptr->inline_capacity) : \
+                                         sizeof(dyn_array_t))
 
 
 
@@ -35,28 +45,90 @@ typedef enum {CREATE_GAP = 0x01, FILL_GAP = 0x02, FILL_GAP_DESTRUCT = 0x06} DYN_
 // The core of any insert/remove operation, check the impl for details
 bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t count, const DYN_SHIFT_MODE mode, void *const data_location);
 
+// The default allocator, plain old malloc/realloc/free
+void *dyn_default_allocate(void *context, const size_t size);
+void *dyn_default_reallocate(void *context, void *pointer, const size_t old_size, const size_t new_size);
+void dyn_default_release(void *context, void *pointer, const size_t size);
+
+// Reallocates to exactly new_capacity objects (which has to fit everything), keeping any ring in one piece
+bool dyn_resize(dyn_array_t *const dyn_array, const size_t new_capacity);
+
+// Copies count objects to/from index position onward, dealing with the wrap
+void dyn_ring_copy(dyn_array_t *const dyn_array, const size_t position, const size_t count, void *const data_location,
+                   const bool into_array);
+
+// memmove for a ring, moves count objects from index from to index to
+void dyn_ring_move(dyn_array_t *const dyn_array, size_t to, size_t from, size_t count);
+
+// Swaps two objects a byte at a time so it needs no scratch space
+void dyn_swap(const dyn_array_t *const dyn_array, uint8_t *const first, uint8_t *const second);
+
+// Rotates the contents so head is 0 and nothing wraps, so the flat array code can take over
+void dyn_ring_straighten(dyn_array_t *const dyn_array);
+
+// The core of the sorted searches, binary search for the first object that is >= (or > for upper) the given one
+size_t dyn_bound(const dyn_array_t *const dyn_array, const void *const object,
+                 int (*compare)(const void *const, const void *const), const bool upper);
+
 
 dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *)) {
-    if (data_type_size && capacity <= DYN_MAX_CAPACITY) {
-        dyn_array_t *dyn_array =  (dyn_array_t *) malloc(sizeof(dyn_array_t));
-        if (dyn_array) {
-            // would have inf loop if requested size was between DYN_MAX_CAPACITY
-            // and SIZE_MAX
-            size_t actual_capacity = 16;
-            while (capacity > actual_capacity) {actual_capacity <<= 1;}
+    return dyn_array_create_flags(capacity, data_type_size, destruct_func, DYN_CREATE_DEFAULT);
+}
 
+dyn_array_t *dyn_array_create_flags(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                    const DYN_CREATE_FLAGS flags) {
+    return dyn_array_create_with_allocator(capacity, data_type_size, destruct_func, flags, NULL);
+}
+
+dyn_array_t *dyn_array_create_with_allocator(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                             const DYN_CREATE_FLAGS flags, const dyn_allocator_t *const allocator) {
+    const dyn_allocator_t default_allocator = {&dyn_default_allocate, &dyn_default_reallocate, &dyn_default_release, NULL};
+    const dyn_allocator_t *const chosen = allocator ? allocator : &default_allocator;
+    if (data_type_size && capacity <= DYN_MAX_CAPACITY && !(flags & ~(DYN_CREATE_RING | DYN_CREATE_INLINE))
+        && chosen->allocate && chosen->reallocate) {
+        // would have inf loop if requested size was between DYN_MAX_CAPACITY
+        // and SIZE_MAX
+        size_t actual_capacity = 16;
+        size_t struct_bytes = sizeof(dyn_array_t);
+        if (flags & DYN_CREATE_INLINE) {
+            // Inline capacity is exactly what they asked for, it's all allocated whether it's used or not
+            actual_capacity = capacity ? capacity : 16;
+            if (actual_capacity > (SIZE_MAX - DYN_INLINE_OFFSET) / data_type_size) {
+                return NULL;
+            }
+            struct_bytes = DYN_INLINE_OFFSET + data_type_size * actual_capacity;
+        } else {
+            while (capacity > actual_capacity) {actual_capacity <<= 1;}
+        }
+        dyn_array_t *dyn_array = (dyn_array_t *) chosen->allocate(chosen->context, struct_bytes);
+        if (dyn_array) {
             dyn_array->capacity = actual_capacity;
             dyn_array->size = 0;
             dyn_array->data_size = data_type_size;
             dyn_array->destructor = destruct_func;
-
-            dyn_array->array = (uint8_t *) malloc(data_type_size * actual_capacity);
+            dyn_array->flags = (flags & DYN_CREATE_RING) ? RING : NONE;
+            dyn_array->head = 0;
+            dyn_array->growth = DYN_GROW_FACTOR;
+            dyn_array->growth_amount = 100;
+            // copied, so theirs doesn't have to outlive the array
+            dyn_array->allocator = *chosen;
+
+            if (flags & DYN_CREATE_INLINE) {
+                // Already have it, that's the point
+                dyn_array->inline_capacity = actual_capacity;
+                dyn_array->array = DYN_INLINE_STORAGE(dyn_array);
+                return dyn_array;
+            }
+            dyn_array->inline_capacity = 0;
+            dyn_array->array = (uint8_t *) chosen->allocate(chosen->context, data_type_size * actual_capacity);
             if (dyn_array->array) {
                 // other malloc worked, yay!
                 // we're done?
                 return dyn_array;
             }
-            free(dyn_array);
+            if (chosen->release) {
+                chosen->release(chosen->context, dyn_array, sizeof(dyn_array_t));
+            }
         }
     }
     return NULL;
@@ -83,14 +155,25 @@ dyn_array_t *dyn_array_import(const void *const data, const size_t count, const
 // or memcpy the pointer's value to a non-const pointer (my favorite trick)
 // Oh C...
 const void *dyn_array_export(const dyn_array_t *const dyn_array) {
+    // A wrapped ring isn't an array, so it gets straightened out first.
+    // That doesn't change the contents, so I'm calling it const enough (trick number two)
+    if (dyn_array && dyn_array->head) {
+        dyn_ring_straighten((dyn_array_t *) dyn_array);
+    }
     return dyn_array_front(dyn_array);
 }
 
 void dyn_array_destroy(dyn_array_t *dyn_array) {
     if (dyn_array) {
         dyn_array_clear(dyn_array);
-        free(dyn_array->array);
-        free(dyn_array);
+        // No release means the allocator gets its memory back some other way (all at once, probably)
+        if (dyn_array->allocator.release) {
+            if (!DYN_IS_INLINE(dyn_array)) {
+                dyn_array->allocator.release(dyn_array->allocator.context, dyn_array->array,
+                                             DYN_SIZE_N_ELEMS(dyn_array, dyn_array->capacity));
+            }
+            dyn_array->allocator.release(dyn_array->allocator.context, dyn_array, DYN_STRUCT_BYTES(dyn_array));
+        }
     }
 }
 
@@ -102,7 +185,7 @@ void *dyn_array_front(const dyn_array_t *const dyn_array) {
         // If array is null, well, this is ok, because it's null
         // but if array is broken, well, we can't help that
         // nor can we detect that, so I guess it's not an error
-        return dyn_array->array;
+        return DYN_ARRAY_POSITION(dyn_array, dyn_array->head);
     }
     return NULL;
 }
@@ -133,7 +216,7 @@ bool dyn_array_extract_front(dyn_array_t *const dyn_array, void *const object) {
 
 void *dyn_array_back(const dyn_array_t *const dyn_array) {
     if (dyn_array && dyn_array->size) {
-        return DYN_ARRAY_POSITION(dyn_array, dyn_array->size - 1);
+        return DYN_ARRAY_AT(dyn_array, dyn_array->size - 1);
     }
     return NULL;
 }
@@ -168,7 +251,7 @@ bool dyn_array_extract_back(dyn_array_t *const dyn_array, void *const object) {
 
 void *dyn_array_at(const dyn_array_t *const dyn_array, const size_t index) {
     if (dyn_array && index < dyn_array->size) {
-        return DYN_ARRAY_POSITION(dyn_array, index);
+        return DYN_ARRAY_AT(dyn_array, index);
     }
     return NULL;
 }
@@ -191,6 +274,48 @@ bool dyn_array_extract(dyn_array_t *const dyn_array, const size_t index, void *c
 
 
 
+// The _n versions are the same calls as their single object versions, dyn_shift always took a count
+// so it's still one memmove for the lot of them
+
+bool dyn_array_insert_n(dyn_array_t *const dyn_array, const size_t index, const void *const objects, const size_t count) {
+    return objects && dyn_shift(dyn_array, index, count, CREATE_GAP, (void *const)objects);
+}
+
+bool dyn_array_erase_n(dyn_array_t *const dyn_array, const size_t index, const size_t count) {
+    return dyn_shift(dyn_array, index, count, FILL_GAP_DESTRUCT, NULL);
+}
+
+bool dyn_array_extract_n(dyn_array_t *const dyn_array, const size_t index, const size_t count, void *const objects) {
+    // FILL_GAP range checks index + count for us
+    return objects && dyn_shift(dyn_array, index, count, FILL_GAP, objects);
+}
+
+bool dyn_array_push_back_n(dyn_array_t *const dyn_array, const void *const objects, const size_t count) {
+    return objects && dyn_array && dyn_shift(dyn_array, dyn_array->size, count, CREATE_GAP, (void *const)objects);
+}
+
+bool dyn_array_append(dyn_array_t *const dst, const dyn_array_t *const src) {
+    if (dst && src && dst->data_size == src->data_size) {
+        // Not using dyn_shift, src may BE dst, and then the realloc would pull the data out from under us
+        // Making room first and copying after handles both (the two halves never overlap)
+        const size_t count = src->size;
+        if (count && dyn_request_size_increase(dst, count)) {
+            // src may wrap (it's read after the increase, which can move it), so it goes over in up to two pieces
+            const size_t first = count < src->capacity - src->head ? count : src->capacity - src->head;
+            dyn_ring_copy(dst, dst->size, first, DYN_ARRAY_POSITION(src, src->head), true);
+            dyn_ring_copy(dst, dst->size + first, count - first, src->array, true);
+            dst->size += count;
+            return true;
+        }
+        // Appending nothing always works
+        return !count;
+    }
+    return false;
+}
+
+
+
+
 void dyn_array_clear(dyn_array_t *const dyn_array) {
     if (dyn_array && dyn_array->size) {
         dyn_shift(dyn_array, 0, dyn_array->size, FILL_GAP_DESTRUCT, NULL);
@@ -228,6 +353,7 @@ bool dyn_array_sort(dyn_array_t *const dyn_array, int (*compare)(const void *, c
     // hah, turns out there's a quicksort in cstdlib.
     // and it works exactly like we want it to
     if (dyn_array && dyn_array->size && compare) {
+        dyn_ring_straighten(dyn_array);
         qsort(dyn_array->array, dyn_array->size, dyn_array->data_size, compare);
         return true;
     }
@@ -238,14 +364,46 @@ bool dyn_array_sort(dyn_array_t *const dyn_array, int (*compare)(const void *, c
 bool dyn_array_insert_sorted(dyn_array_t *const dyn_array, const void *const object,
                              int (*compare)(const void *, const void *)) {
     if (dyn_array && compare && object) {
-        size_t ordered_position = 0;
-        if (dyn_array->size) {
-            while (ordered_position < dyn_array->size &&
-                    compare(object, DYN_ARRAY_POSITION(dyn_array, ordered_position)) > 0) {
-                ++ordered_position;
-            }
+        // Goes in front of anything equal to it, same as it always has
+        return dyn_shift(dyn_array, dyn_bound(dyn_array, object, compare, false), 1, CREATE_GAP, (void *const) object);
+    }
+    return false;
+}
+
+size_t dyn_array_lower_bound(const dyn_array_t *const dyn_array, const void *const object,
+                             int (*compare)(const void *const, const void *const)) {
+    if (dyn_array && object && compare) {
+        return dyn_bound(dyn_array, object, compare, false);
+    }
+    return SIZE_MAX;
+}
+
+size_t dyn_array_upper_bound(const dyn_array_t *const dyn_array, const void *const object,
+                             int (*compare)(const void *const, const void *const)) {
+    if (dyn_array && object && compare) {
+        return dyn_bound(dyn_array, object, compare, true);
+    }
+    return SIZE_MAX;
+}
+
+void *dyn_array_bsearch(const dyn_array_t *const dyn_array, const void *const object,
+                        int (*compare)(const void *const, const void *const)) {
+    if (dyn_array && object && compare) {
+        // lower_bound lands on the first match, if there is one
+        const size_t position = dyn_bound(dyn_array, object, compare, false);
+        if (position < dyn_array->size && compare(object, DYN_ARRAY_AT(dyn_array, position)) == 0) {
+            return DYN_ARRAY_AT(dyn_array, position);
         }
-        return dyn_shift(dyn_array, ordered_position, 1, CREATE_GAP, (void *const) object);
+    }
+    return NULL;
+}
+
+bool dyn_array_equal_range(const dyn_array_t *const dyn_array, const void *const object,
+                           int (*compare)(const void *const, const void *const), size_t *const first, size_t *const last) {
+    if (dyn_array && object && compare && first && last) {
+        *first = dyn_bound(dyn_array, object, compare, false);
+        *last = dyn_bound(dyn_array, object, compare, true);
+        return true;
     }
     return false;
 }
@@ -257,28 +415,112 @@ bool dyn_array_for_each(dyn_array_t *const dyn_array, void (*func)(void *const))
         // Which is both unsafe and potentially undefined behavior
         // Although we're the only ones that touch the pointer and we always validate it.
         // So it's questionable. We'll check it here.
-        uint8_t *data_walker = (uint8_t *)dyn_array->array;
-        for (size_t idx = 0; idx < dyn_array->size; ++idx, data_walker += dyn_array->data_size) {
-            func((void *const) data_walker);
+        for (size_t idx = 0; idx < dyn_array->size; ++idx) {
+            func((void *const) DYN_ARRAY_AT(dyn_array, idx));
         }
         return true;
     }
     return false;
 }
 
+size_t dyn_array_remove_if(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                           void *const context) {
+    if (dyn_array && predicate) {
+        // Objects [run, idx) are staying but haven't moved down to kept yet
+        // Each run goes down in one move as soon as something after it is removed
+        // Nothing moves before it's been looked at, since kept <= run <= idx
+        size_t kept = 0, run = 0;
+        for (size_t idx = 0; idx <= dyn_array->size; ++idx) {
+            void *const object = (idx < dyn_array->size) ? DYN_ARRAY_AT(dyn_array, idx) : NULL;
+            if (!object || predicate(object, context)) {
+                if (kept != run) {
+                    dyn_ring_move(dyn_array, kept, run, idx - run);
+                }
+                kept += idx - run;
+                run = idx + 1;
+                if (object && dyn_array->destructor) {
+                    dyn_array->destructor(object);
+                }
+            }
+        }
+        const size_t removed = dyn_array->size - kept;
+        dyn_array->size = kept;
+        if (!kept) {
+            dyn_array->head = 0;
+        }
+        return removed;
+    }
+    return 0;
+}
 
-/*
-    // No return value. It either goes or it doesn't. shrink_to_fit is more of a request
-    void dyn_array_shrink_to_fit(dyn_array_t *const dyn_array) {
-    if (dyn_array) {
-        void *new_address = realloc(dyn_array->data, DYN_ARRAY_SIZE_N_ELEMS(dyn_array, dyn_array->size));
-        if (new_address) {
-            dyn_array->data = new_address;
-            SET_FLAG(dyn_array,SHRUNK);
+size_t dyn_array_partition(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                           void *const context) {
+    if (dyn_array && predicate) {
+        // [0, first) passed, [last, size) failed, the predicate only ever sees each object once
+        size_t first = 0, last = dyn_array->size;
+        while (true) {
+            while (first < last && predicate(DYN_ARRAY_AT(dyn_array, first), context)) {
+                ++first;
+            }
+            // first (if it's still < last) already failed, don't ask about it again
+            while (first + 1 < last && !predicate(DYN_ARRAY_AT(dyn_array, last - 1), context)) {
+                --last;
+            }
+            if (first + 1 >= last) {
+                return first;
+            }
+            dyn_swap(dyn_array, DYN_ARRAY_AT(dyn_array, first), DYN_ARRAY_AT(dyn_array, last - 1));
+            ++first;
+            --last;
         }
     }
+    return 0;
+}
+
+
+bool dyn_array_reserve(dyn_array_t *const dyn_array, const size_t capacity) {
+    if (dyn_array && capacity <= DYN_MAX_CAPACITY) {
+        // Exactly what they asked for, they know how much they're about to put in better than we do
+        return capacity <= dyn_array->capacity || dyn_resize(dyn_array, capacity);
+    }
+    return false;
+}
+
+bool dyn_array_shrink_to_fit(dyn_array_t *const dyn_array) {
+    if (dyn_array) {
+        // realloc to 0 bytes is implementation defined (it may even free it), so empty arrays keep room for one
+        const size_t fit = dyn_array->size ? dyn_array->size : 1;
+        // Growth never assumed a power of two, so there's no flag to set afterwards (SHRUNK was the plan)
+        return fit == dyn_array->capacity || dyn_resize(dyn_array, fit);
+    }
+    return false;
+}
+
+bool dyn_array_set_growth(dyn_array_t *const dyn_array, const DYN_GROWTH_POLICY policy, const size_t amount) {
+    if (dyn_array) {
+        switch (policy) {
+            case DYN_GROW_FACTOR:
+                // Capped so the capacity math can't overflow
+                if (amount == 0 || amount > 1000) {
+                    return false;
+                }
+                break;
+            case DYN_GROW_CHUNK:
+                if (amount == 0 || amount > DYN_MAX_CAPACITY) {
+                    return false;
+                }
+                break;
+            case DYN_GROW_EXACT:
+                break;
+            default:
+                return false;
+        }
+        dyn_array->growth = policy;
+        dyn_array->growth_amount = amount;
+        return true;
     }
-*/
+    return false;
+}
 
 
 //
@@ -326,6 +568,10 @@ bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t
     // if the pointer was bad, the data structure wasn't changed (unless it was deconstruction)
     // can't const const the pointer because then we can't write to it on extract
 
+    // VERSION 3.0
+    // RING arrays can move head, so they move whichever side of the gap is shorter
+    // Gaps at the front or back don't move anything at all, head just moves over count slots
+
 
     if (dyn_array && count) {
         // dyn good, count ok
@@ -334,14 +580,22 @@ bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t
             // We'll ask the capacity function if we can do it.
             // If we can, do it. If not... Too bad for the user.
             if (position <= dyn_array->size && dyn_request_size_increase(dyn_array, count)) {
-                if (position != dyn_array->size) { // wasn't a gap at the end, we need to move data
+                if (dyn_array->flags & RING) {
+                    if (position < dyn_array->size - position) {
+                        // back the head up (count <= capacity - size here, so this wraps at most once)
+                        // and slide the front down into the new space
+                        dyn_array->head = (dyn_array->head >= count) ? dyn_array->head - count
+                                                                     : dyn_array->head + dyn_array->capacity - count;
+                        dyn_ring_move(dyn_array, 0, count, position);
+                    } else {
+                        dyn_ring_move(dyn_array, position + count, position, dyn_array->size - position);
+                    }
+                } else if (position != dyn_array->size) { // wasn't a gap at the end, we need to move data
                     memmove(DYN_ARRAY_POSITION(dyn_array, position + count),
                             DYN_ARRAY_POSITION(dyn_array, position),
                             DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - position));
                 }
-                memcpy(DYN_ARRAY_POSITION(dyn_array, position),
-                       data_location,
-                       dyn_array->data_size * count);
+                dyn_ring_copy(dyn_array, position, count, data_location, true);
                 dyn_array->size += count;
                 return true;
             }
@@ -349,20 +603,17 @@ bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t
             // shrinking in size
             // nice and simple (?)
 
-            // verify size and range
-            if ((position + count) <= dyn_array->size) {
+            // verify size and range (without adding, a huge count would wrap)
+            if (position <= dyn_array->size && count <= dyn_array->size - position) {
                 if (mode == FILL_GAP_DESTRUCT) {
                     if (dyn_array->destructor) { // destruct AND HAVE DESTRUCTOR
-                        uint8_t *arr_pos = DYN_ARRAY_POSITION(dyn_array, position);
-                        for (size_t total = count; total; --total, arr_pos += dyn_array->data_size) {
-                            dyn_array->destructor(arr_pos);
+                        for (size_t idx = position; idx < position + count; ++idx) {
+                            dyn_array->destructor(DYN_ARRAY_AT(dyn_array, idx));
                         }
                     }
                 } else {
                     if (data_location) {
-                        memcpy(data_location,
-                               DYN_ARRAY_POSITION(dyn_array, position),
-                               dyn_array->data_size * count);
+                        dyn_ring_copy(dyn_array, position, count, data_location, false);
                     } else {
                         return false;
                     }
@@ -370,7 +621,15 @@ bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t
                 // pointer arithmatic on void pointers is illegal nowadays :C
                 // GCC allows it for compatability, other provide it for GCC compatability. Way to implement a standard.
                 // It should be cast to some sort of byte pointer, which is a pain. Hooray for macros
-                if (position + count < dyn_array->size) {
+                if (dyn_array->flags & RING) {
+                    if (position < dyn_array->size - (position + count)) {
+                        // slide the front up to the gap and move the head up after it
+                        dyn_ring_move(dyn_array, count, 0, position);
+                        dyn_array->head = DYN_RING_SLOT(dyn_array, count);
+                    } else {
+                        dyn_ring_move(dyn_array, position, position + count, dyn_array->size - (position + count));
+                    }
+                } else if (position + count < dyn_array->size) {
                     // there's a actual gap, not just a hole to make at the end
                     memmove(DYN_ARRAY_POSITION(dyn_array, position),
                             DYN_ARRAY_POSITION(dyn_array, position + count),
@@ -378,6 +637,10 @@ bool dyn_shift(dyn_array_t *const dyn_array, const size_t position, const size_t
                 }
                 // decrease the size and return
                 dyn_array->size -= count;
+                if (dyn_array->size == 0) {
+                    // may as well start over from the top
+                    dyn_array->head = 0;
+                }
                 return true;
             }
         }
@@ -390,7 +653,10 @@ bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increm
     // and increase capacity if need be
     // average case will be perfectly fine, single increment
     if (dyn_array) {
-        //if (!ADDITION_MAY_OVERFLOW(dyn_array->size, increment)) {
+        // the _n functions pass the caller's count straight through, so size + increment can wrap
+        if (increment > DYN_MAX_CAPACITY - dyn_array->size) {
+            return false;
+        }
         // increment is ok, but is the capacity?
         if (dyn_array->capacity >= (dyn_array->size + increment)) {
             // capacity is ok!
@@ -399,23 +665,201 @@ bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increm
         // have to reallocate, is that even possible?
         size_t needed_size = dyn_array->size + increment;
 
-        // INSERT SHRINK_TO_FIT CORRECTION HERE
-
         if (needed_size <= DYN_MAX_CAPACITY) {
-            size_t new_capacity = dyn_array->capacity << 1;
-            while (new_capacity < needed_size) {new_capacity <<= 1;}
+            size_t new_capacity = dyn_array->capacity;
+            switch (dyn_array->growth) {
+                case DYN_GROW_EXACT:
+                    new_capacity = needed_size;
+                    break;
+                case DYN_GROW_CHUNK:
+                    // Whole chunks, enough of them to fit
+                    new_capacity += ((needed_size - new_capacity + dyn_array->growth_amount - 1) / dyn_array->growth_amount)
+                                    * dyn_array->growth_amount;
+                    break;
+                default:
+                    // growth_amount percent at a time (100 is the good old doubling)
+                    // shrink_to_fit can leave us tiny, so it always grows by at least one
+                    while (new_capacity < needed_size) {
+                        const size_t step = (new_capacity / 100) * dyn_array->growth_amount
+                                            + ((new_capacity % 100) * dyn_array->growth_amount) / 100;
+                        new_capacity += step ? step : 1;
+                    }
+                    break;
+            }
+            // Overshooting the cap is fine, as long as what we actually need is under it
+            if (new_capacity > DYN_MAX_CAPACITY) {
+                new_capacity = DYN_MAX_CAPACITY;
+            }
 
             // we can theoretically hold this, check if we can allocate that
             //if (!MULTIPLY_MAY_OVERFLOW(new_capacity, dyn_array->data_size)) {
             // we won't overflow, so we can at least REQUEST this change
-            void *new_array = realloc(dyn_array->array, new_capacity * dyn_array->data_size);
+            return dyn_resize(dyn_array, new_capacity);
+        }
+    }
+    return false;
+}
+
+bool dyn_resize(dyn_array_t *const dyn_array, const size_t new_capacity) {
+    if (dyn_array->inline_capacity) {
+        if (new_capacity <= dyn_array->inline_capacity) {
+            // Inline storage is always there, so never going smaller than it, and coming back is free
+            if (!DYN_IS_INLINE(dyn_array)) {
+                void *const heap_array = dyn_array->array;
+                const size_t heap_bytes = DYN_SIZE_N_ELEMS(dyn_array, dyn_array->capacity);
+                dyn_ring_copy(dyn_array, 0, dyn_array->size, DYN_INLINE_STORAGE(dyn_array), false);
+                dyn_array->array = DYN_INLINE_STORAGE(dyn_array);
+                dyn_array->head = 0;
+                dyn_array->capacity = dyn_array->inline_capacity;
+                if (dyn_array->allocator.release) {
+                    dyn_array->allocator.release(dyn_array->allocator.context, heap_array, heap_bytes);
+                }
+            }
+            return true;
+        }
+        if (DYN_IS_INLINE(dyn_array)) {
+            // Outgrew it, off to the heap (straightened out on the way, it's a copy anyway)
+            void *new_array = dyn_array->allocator.allocate(dyn_array->allocator.context,
+                                                            DYN_SIZE_N_ELEMS(dyn_array, new_capacity));
             if (new_array) {
-                // success! Wasn't that easy?
+                dyn_ring_copy(dyn_array, 0, dyn_array->size, new_array, false);
                 dyn_array->array = new_array;
+                dyn_array->head = 0;
                 dyn_array->capacity = new_capacity;
                 return true;
             }
+            return false;
         }
     }
+    if (new_capacity < dyn_array->capacity) {
+        // The slots getting cut off have to be empty, so line everything up at the start
+        dyn_ring_straighten(dyn_array);
+    }
+    void *new_array = dyn_array->allocator.reallocate(dyn_array->allocator.context, dyn_array->array,
+                                                      DYN_SIZE_N_ELEMS(dyn_array, dyn_array->capacity),
+                                                      DYN_SIZE_N_ELEMS(dyn_array, new_capacity));
+    if (new_array) {
+        // success! Wasn't that easy?
+        dyn_array->array = new_array;
+        if (dyn_array->head + dyn_array->size > dyn_array->capacity) {
+            // A wrapped ring, the piece from head to the old end goes to the new end to close the gap
+            const size_t head_count = dyn_array->capacity - dyn_array->head;
+            memmove(DYN_ARRAY_POSITION(dyn_array, new_capacity - head_count),
+                    DYN_ARRAY_POSITION(dyn_array, dyn_array->head),
+                    DYN_SIZE_N_ELEMS(dyn_array, head_count));
+            dyn_array->head = new_capacity - head_count;
+        }
+        dyn_array->capacity = new_capacity;
+        return true;
+    }
     return false;
 }
+
+size_t dyn_bound(const dyn_array_t *const dyn_array, const void *const object,
+                 int (*compare)(const void *const, const void *const), const bool upper) {
+    // Standard binary search, [low, high) is where the answer can still be
+    // Lower bound moves past anything less than the object, upper bound past anything less or equal
+    size_t low = 0, high = dyn_array->size;
+    while (low < high) {
+        const size_t middle = low + ((high - low) >> 1);
+        const int result = compare(object, DYN_ARRAY_AT(dyn_array, middle));
+        if (upper ? result >= 0 : result > 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void dyn_ring_copy(dyn_array_t *const dyn_array, const size_t position, const size_t count, void *const data_location,
+                   const bool into_array) {
+    // [position, position + count) is at most two runs of slots, the end of the buffer and the start
+    // (plain arrays never wrap, so the second one is always empty for them)
+    const size_t slot = DYN_RING_SLOT(dyn_array, position);
+    const size_t first = (count < dyn_array->capacity - slot) ? count : dyn_array->capacity - slot;
+    uint8_t *const data = (uint8_t *) data_location;
+    if (into_array) {
+        memcpy(DYN_ARRAY_POSITION(dyn_array, slot), data, DYN_SIZE_N_ELEMS(dyn_array, first));
+        memcpy(dyn_array->array, data + DYN_SIZE_N_ELEMS(dyn_array, first), DYN_SIZE_N_ELEMS(dyn_array, count - first));
+    } else {
+        memcpy(data, DYN_ARRAY_POSITION(dyn_array, slot), DYN_SIZE_N_ELEMS(dyn_array, first));
+        memcpy(data + DYN_SIZE_N_ELEMS(dyn_array, first), dyn_array->array, DYN_SIZE_N_ELEMS(dyn_array, count - first));
+    }
+}
+
+void dyn_ring_move(dyn_array_t *const dyn_array, size_t to, size_t from, size_t count) {
+    // Source and destination can each wrap, so it goes a piece at a time, each piece stopping at
+    // whichever of them hits the end of the buffer first. Same as memmove, the direction is picked
+    // so the overlap is never overwritten before it's read
+    if (to < from) {
+        while (count) {
+            const size_t src = DYN_RING_SLOT(dyn_array, from), dst = DYN_RING_SLOT(dyn_array, to);
+            size_t piece = dyn_array->capacity - (src > dst ? src : dst);
+            piece = (count < piece) ? count : piece;
+            memmove(DYN_ARRAY_POSITION(dyn_array, dst), DYN_ARRAY_POSITION(dyn_array, src), DYN_SIZE_N_ELEMS(dyn_array, piece));
+            from += piece;
+            to += piece;
+            count -= piece;
+        }
+    } else if (to > from) {
+        while (count) {
+            // pieces end at the slot after the last object, so they run back to slot 0 at most
+            const size_t src = DYN_RING_SLOT(dyn_array, from + count - 1) + 1, dst = DYN_RING_SLOT(dyn_array, to + count - 1) + 1;
+            size_t piece = (src < dst) ? src : dst;
+            piece = (count < piece) ? count : piece;
+            memmove(DYN_ARRAY_POSITION(dyn_array, dst - piece), DYN_ARRAY_POSITION(dyn_array, src - piece),
+                    DYN_SIZE_N_ELEMS(dyn_array, piece));
+            count -= piece;
+        }
+    }
+}
+
+void *dyn_default_allocate(void *context, const size_t size) {
+    return malloc(size);
+}
+
+void *dyn_default_reallocate(void *context, void *pointer, const size_t old_size, const size_t new_size) {
+    return realloc(pointer, new_size);
+}
+
+void dyn_default_release(void *context, void *pointer, const size_t size) {
+    free(pointer);
+}
+
+void dyn_swap(const dyn_array_t *const dyn_array, uint8_t *const first, uint8_t *const second) {
+    for (size_t byte = 0; byte < dyn_array->data_size; ++byte) {
+        const uint8_t temp = first[byte];
+        first[byte] = second[byte];
+        second[byte] = temp;
+    }
+}
+
+// Reverses the objects in slots [first, last)
+void dyn_reverse(dyn_array_t *const dyn_array, size_t first, size_t last) {
+    for (; first + 1 < last; ++first, --last) {
+        dyn_swap(dyn_array, DYN_ARRAY_POSITION(dyn_array, first), DYN_ARRAY_POSITION(dyn_array, last - 1));
+    }
+}
+
+void dyn_ring_straighten(dyn_array_t *const dyn_array) {
+    if (dyn_array->head) {
+        // Objects from head to the end of the buffer
+        const size_t first = (dyn_array->size < dyn_array->capacity - dyn_array->head) ? dyn_array->size
+                                                                                       : dyn_array->capacity - dyn_array->head;
+        if (first == dyn_array->size) {
+            // Doesn't wrap, just slide it down
+            memmove(dyn_array->array, DYN_ARRAY_POSITION(dyn_array, dyn_array->head), DYN_SIZE_N_ELEMS(dyn_array, first));
+        } else {
+            // [B][ ][A] -> [B][A][ ] -> [A][B][ ]
+            // The second step is a rotation, which is three reverses (no malloc, so this can't fail)
+            const size_t wrapped = dyn_array->size - first;
+            memmove(DYN_ARRAY_POSITION(dyn_array, wrapped), DYN_ARRAY_POSITION(dyn_array, dyn_array->head),
+                    DYN_SIZE_N_ELEMS(dyn_array, first));
+            dyn_reverse(dyn_array, 0, dyn_array->size);
+            dyn_reverse(dyn_array, 0, first);
+            dyn_reverse(dyn_array, first, dyn_array->size);
+        }
+        dyn_array->head = 0;
+    }
+}
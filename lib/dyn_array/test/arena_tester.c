@@ -0,0 +1,321 @@
+#include "../include/dyn_arena.h"
+#include "../src/dyn_array.c"
+#include "../src/dyn_arena.c"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+    dyn_arena_t *dyn_arena_create(const size_t block_size);
+    1. Normal, default block size
+    2. Normal, given block size
+    3. Fail, block size too big to ever allocate
+
+    void *dyn_arena_alloc(dyn_arena_t *const arena, const size_t size);
+    4. Normal, aligned, never overlapping, spills into new blocks, oversized gets its own block
+    5. Fail, zero size, NULL
+
+    void dyn_arena_reset(dyn_arena_t *const arena);
+    6. Normal, blocks get reused, no new blocks for the same workload again
+
+    const dyn_allocator_t *dyn_arena_allocator(const dyn_arena_t *const arena);
+    7. Normal, reallocate grows the newest allocation in place, copies anything else
+    8. Normal, release only takes back the newest allocation
+    9. Fail, NULL
+
+    dyn_array_t *dyn_array_create_with_allocator(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                                 const DYN_CREATE_FLAGS flags, const dyn_allocator_t *const allocator);
+    10. Normal, array in an arena, grows, works like any other (ring too), destructors still run
+    11. Normal, NULL allocator is malloc
+    12. Normal, counting allocator sees every allocate/reallocate/release, sizes match up
+    13. Fail, allocator missing allocate/reallocate, allocator out of memory
+    14. Normal, DYN_CREATE_INLINE is one allocate, heap only once it's outgrown, released going back inline
+    15. Normal, DYN_CREATE_INLINE in an arena
+
+    DYN_ARRAY_DEFINE(name, type, cmp) (dyn_array_typed.h)
+    16. Normal, name_sort gets its scratch space from the array's allocator (and gives it back)
+*/
+
+size_t arena_blocks(const dyn_arena_t *const arena) {
+    size_t count = 0;
+    for (const dyn_arena_block_t *block = arena->first; block; block = block->next) {
+        ++count;
+    }
+    return count;
+}
+
+// Counts everything going through it (and passes it on to malloc), or fails once out of budget
+typedef struct {
+    size_t allocates, reallocates, releases, live_bytes, budget;
+} counting_context_t;
+
+void *counting_allocate(void *context, const size_t size) {
+    counting_context_t *counts = (counting_context_t *) context;
+    if (counts->allocates + counts->reallocates >= counts->budget) {
+        return NULL;
+    }
+    ++counts->allocates;
+    counts->live_bytes += size;
+    return malloc(size);
+}
+
+void *counting_reallocate(void *context, void *pointer, const size_t old_size, const size_t new_size) {
+    counting_context_t *counts = (counting_context_t *) context;
+    if (counts->allocates + counts->reallocates >= counts->budget) {
+        return NULL;
+    }
+    ++counts->reallocates;
+    counts->live_bytes += new_size - old_size;
+    return realloc(pointer, new_size);
+}
+
+void counting_release(void *context, void *pointer, const size_t size) {
+    counting_context_t *counts = (counting_context_t *) context;
+    ++counts->releases;
+    counts->live_bytes -= size;
+    free(pointer);
+}
+
+int destructed;
+void count_destructor(void *object) {
+    ++destructed;
+}
+
+#define size_compare(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+DYN_ARRAY_DEFINE(size_array, size_t, size_compare)
+
+void arena_test_a();
+void arena_test_b();
+
+int main() {
+
+    // ARENA
+    arena_test_a();
+
+    // ARRAYS WITH ALLOCATORS
+    arena_test_b();
+
+    puts("TESTS PASSED");
+}
+
+void arena_test_a() {
+    // 1
+    dyn_arena_t *arena = dyn_arena_create(0);
+    assert(arena);
+    assert(arena_blocks(arena) == 1 && arena->first->size == DYN_ARENA_DEFAULT_BLOCK);
+    dyn_arena_destroy(arena);
+
+    // 3
+    assert(dyn_arena_create(SIZE_MAX) == NULL);
+
+    // 2
+    arena = dyn_arena_create(1000);
+    assert(arena);
+    assert(arena->first->size == 1008);
+
+    // 4
+    uint8_t *pointers[100];
+    for (size_t idx = 0; idx < 100; ++idx) {
+        pointers[idx] = (uint8_t *) dyn_arena_alloc(arena, idx + 1);
+        assert(pointers[idx]);
+        assert(((uintptr_t) pointers[idx]) % DYN_ARENA_ALIGN == 0);
+        memset(pointers[idx], (int) idx, idx + 1);
+    }
+    for (size_t idx = 0; idx < 100; ++idx) {
+        for (size_t byte = 0; byte <= idx; ++byte) {
+            assert(pointers[idx][byte] == (uint8_t) idx);
+        }
+    }
+    const size_t blocks = arena_blocks(arena);
+    assert(blocks > 1);
+    uint8_t *big = (uint8_t *) dyn_arena_alloc(arena, 5000);
+    assert(big);
+    memset(big, 0xAB, 5000);
+    assert(arena_blocks(arena) == blocks + 1);
+    assert(arena->current->size == 5008);
+
+    // 5
+    assert(dyn_arena_alloc(arena, 0) == NULL);
+    assert(dyn_arena_alloc(NULL, 10) == NULL);
+    assert(dyn_arena_alloc(arena, SIZE_MAX) == NULL);
+
+    // 6
+    dyn_arena_reset(arena);
+    assert(dyn_arena_alloc(arena, 16) == DYN_ARENA_DATA(arena->first));
+    dyn_arena_reset(arena);
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(dyn_arena_alloc(arena, idx + 1));
+    }
+    assert(dyn_arena_alloc(arena, 5000));
+    assert(arena_blocks(arena) == blocks + 1);
+    dyn_arena_reset(arena);
+    dyn_arena_reset(NULL);
+
+    // 7
+    const dyn_allocator_t *allocator = dyn_arena_allocator(arena);
+    assert(allocator && allocator->context == arena);
+    uint8_t *first = (uint8_t *) allocator->allocate(allocator->context, 10);
+    memset(first, 0x11, 10);
+    uint8_t *grown = (uint8_t *) allocator->reallocate(allocator->context, first, 10, 100);
+    assert(grown == first);
+    uint8_t *second = (uint8_t *) allocator->allocate(allocator->context, 10);
+    assert(second == first + 112);
+    grown = (uint8_t *) allocator->reallocate(allocator->context, first, 100, 200);
+    assert(grown && grown != first && grown[0] == 0x11 && grown[9] == 0x11);
+    grown = (uint8_t *) allocator->reallocate(allocator->context, grown, 200, 2000);
+    assert(grown && grown[0] == 0x11 && grown[9] == 0x11);
+
+    // 8
+    uint8_t *third = (uint8_t *) allocator->allocate(allocator->context, 10);
+    allocator->release(allocator->context, third, 10);
+    assert(allocator->allocate(allocator->context, 10) == third);
+    allocator->release(allocator->context, second, 10);
+    assert(allocator->allocate(allocator->context, 10) != second);
+
+    // 9
+    assert(dyn_arena_allocator(NULL) == NULL);
+    dyn_arena_destroy(arena);
+    dyn_arena_destroy(NULL);
+}
+
+void arena_test_b() {
+    // 10
+    dyn_arena_t *arena = dyn_arena_create(0);
+    assert(arena);
+    const size_t blocks = arena_blocks(arena);
+    for (size_t round = 0; round < 3; ++round) {
+        dyn_array_t *array = dyn_array_create_with_allocator(0, sizeof(size_t), &count_destructor, DYN_CREATE_DEFAULT,
+                                                             dyn_arena_allocator(arena));
+        dyn_array_t *ring = dyn_array_create_with_allocator(4, sizeof(size_t), NULL, DYN_CREATE_RING,
+                                                            dyn_arena_allocator(arena));
+        assert(array && ring);
+        for (size_t idx = 0; idx < 300; ++idx) {
+            assert(dyn_array_push_back(array, &idx));
+            assert(dyn_array_push_front(ring, &idx));
+        }
+        for (size_t idx = 0; idx < 300; ++idx) {
+            assert(*(size_t *) dyn_array_at(array, idx) == idx);
+            assert(*(size_t *) dyn_array_at(ring, idx) == 299 - idx);
+        }
+        assert(dyn_array_shrink_to_fit(array) && dyn_array_capacity(array) == 300);
+        destructed = 0;
+        dyn_array_destroy(array);
+        assert(destructed == 300);
+        dyn_array_destroy(ring);
+        // Same work every round, so after the first one it all fits in the blocks we already have
+        if (round == 0) {
+            assert(arena_blocks(arena) > blocks);
+        }
+        const size_t used_blocks = arena_blocks(arena);
+        dyn_arena_reset(arena);
+        assert(arena_blocks(arena) == used_blocks);
+    }
+    dyn_arena_destroy(arena);
+
+    // 11
+    dyn_array_t *array = dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, NULL);
+    assert(array);
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(dyn_array_push_back(array, &idx));
+    }
+    dyn_array_destroy(array);
+
+    // 12
+    counting_context_t counts = {0, 0, 0, 0, SIZE_MAX};
+    const dyn_allocator_t counting = {&counting_allocate, &counting_reallocate, &counting_release, &counts};
+    array = dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &counting);
+    assert(array);
+    assert(counts.allocates == 2 && counts.live_bytes == sizeof(dyn_array_t) + 16 * sizeof(size_t));
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(dyn_array_push_back(array, &idx));
+    }
+    assert(counts.reallocates == 3 && counts.live_bytes == sizeof(dyn_array_t) + 128 * sizeof(size_t));
+    assert(dyn_array_reserve(array, 200));
+    assert(counts.reallocates == 4 && counts.live_bytes == sizeof(dyn_array_t) + 200 * sizeof(size_t));
+    dyn_array_destroy(array);
+    assert(counts.releases == 2 && counts.live_bytes == 0);
+
+    // 13
+    const dyn_allocator_t missing_allocate = {NULL, &counting_reallocate, &counting_release, &counts};
+    const dyn_allocator_t missing_reallocate = {&counting_allocate, NULL, &counting_release, &counts};
+    assert(dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &missing_allocate) == NULL);
+    assert(dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &missing_reallocate) == NULL);
+    counts = (counting_context_t) {0, 0, 0, 0, 1};
+    assert(dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &counting) == NULL);
+    assert(counts.releases == 1 && counts.live_bytes == 0);
+    counts = (counting_context_t) {0, 0, 0, 0, 2};
+    array = dyn_array_create_with_allocator(0, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &counting);
+    assert(array);
+    for (size_t idx = 0; idx < 16; ++idx) {
+        assert(dyn_array_push_back(array, &idx));
+    }
+    assert(dyn_array_push_back(array, &counts) == false);
+    assert(dyn_array_size(array) == 16);
+    dyn_array_destroy(array);
+    assert(counts.live_bytes == 0);
+
+    // 14
+    counts = (counting_context_t) {0, 0, 0, 0, SIZE_MAX};
+    array = dyn_array_create_with_allocator(8, sizeof(size_t), NULL, DYN_CREATE_INLINE, &counting);
+    assert(array);
+    assert(counts.allocates == 1 && counts.live_bytes == DYN_INLINE_OFFSET + 8 * sizeof(size_t));
+    for (size_t idx = 0; idx < 8; ++idx) {
+        assert(dyn_array_push_back(array, &idx));
+    }
+    assert(counts.allocates == 1 && counts.reallocates == 0);
+    assert(dyn_array_push_back(array, &counts));
+    assert(counts.allocates == 2 && counts.reallocates == 0);
+    assert(counts.live_bytes == DYN_INLINE_OFFSET + 8 * sizeof(size_t) + 16 * sizeof(size_t));
+    assert(dyn_array_pop_back(array) && dyn_array_shrink_to_fit(array));
+    assert(counts.releases == 1 && counts.live_bytes == DYN_INLINE_OFFSET + 8 * sizeof(size_t));
+    for (size_t idx = 0; idx < 8; ++idx) {
+        assert(*(size_t *) dyn_array_at(array, idx) == idx);
+    }
+    dyn_array_destroy(array);
+    assert(counts.releases == 2 && counts.live_bytes == 0);
+    counts = (counting_context_t) {0, 0, 0, 0, 1};
+    array = dyn_array_create_with_allocator(2, sizeof(size_t), NULL, DYN_CREATE_INLINE, &counting);
+    assert(array);
+    assert(dyn_array_push_back_n(array, &counts, 2));
+    assert(dyn_array_push_back(array, &counts) == false);
+    assert(DYN_IS_INLINE(array) && dyn_array_size(array) == 2);
+    dyn_array_destroy(array);
+    assert(counts.live_bytes == 0);
+
+    // 15
+    arena = dyn_arena_create(0);
+    assert(arena);
+    array = dyn_array_create_with_allocator(4, sizeof(size_t), &count_destructor, DYN_CREATE_RING | DYN_CREATE_INLINE,
+                                            dyn_arena_allocator(arena));
+    assert(array && DYN_IS_INLINE(array));
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(dyn_array_push_front(array, &idx));
+    }
+    assert(!DYN_IS_INLINE(array));
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(*(size_t *) dyn_array_at(array, idx) == 99 - idx);
+    }
+    destructed = 0;
+    dyn_array_destroy(array);
+    assert(destructed == 100);
+    dyn_arena_destroy(arena);
+
+    // 16
+    counts = (counting_context_t) {0, 0, 0, 0, SIZE_MAX};
+    array = dyn_array_create_with_allocator(100, sizeof(size_t), NULL, DYN_CREATE_DEFAULT, &counting);
+    assert(array);
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(size_array_push_back(array, (idx * 37) % 100));
+    }
+    const size_t live_bytes = counts.live_bytes;
+    assert(size_array_sort(array));
+    assert(counts.allocates == 3 && counts.releases == 1 && counts.live_bytes == live_bytes);
+    for (size_t idx = 0; idx < 100; ++idx) {
+        assert(*size_array_at(array, idx) == idx);
+    }
+    dyn_array_destroy(array);
+    assert(counts.live_bytes == 0);
+}
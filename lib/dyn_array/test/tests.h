@@ -185,6 +185,121 @@
         2. NORMAL, empty
         3. FAIL, null array
         4. FAIL, null func
+
+    size_t dyn_array_lower_bound(const dyn_array_t *const dyn_array, const void *const object,
+                                 int (*compare)(const void *const, const void *const));
+    size_t dyn_array_upper_bound(const dyn_array_t *const dyn_array, const void *const object,
+                                 int (*compare)(const void *const, const void *const));
+        1. NORMAL, front, middle, back, past the end, with duplicates
+        2. NORMAL, empty
+        3. FAIL, null array
+        4. FAIL, null object
+        5. FAIL, null comparator
+
+    void *dyn_array_bsearch(const dyn_array_t *const dyn_array, const void *const object,
+                            int (*compare)(const void *const, const void *const));
+        1. NORMAL, found (first of the duplicates)
+        2. NORMAL, not found
+        3. FAIL, null array/object/comparator
+
+    bool dyn_array_equal_range(const dyn_array_t *const dyn_array, const void *const object,
+                               int (*compare)(const void *const, const void *const), size_t *const first, size_t *const last);
+        1. NORMAL, duplicates, single, missing
+        2. FAIL, null array/object/comparator/first/last
+
+    bool dyn_array_insert_n(dyn_array_t *const dyn_array, const size_t index, const void *const objects, const size_t count);
+        1. NORMAL, front, back, arbitrary, empty (order kept)
+        2. NORMAL, growing past capacity
+        3. FAIL, out of bounds
+        4. FAIL, count = 0
+        5. FAIL, null array/objects
+        6. FAIL, past max capacity (including count = SIZE_MAX, which wraps size + count)
+
+    bool dyn_array_push_back_n(dyn_array_t *const dyn_array, const void *const objects, const size_t count);
+        SEE INSERT_N (index = size)
+
+    bool dyn_array_erase_n(dyn_array_t *const dyn_array, const size_t index, const size_t count);
+        1. NORMAL, front, back, arbitrary, with destructor
+        2. FAIL, range past the end (including a count that wraps index + count)
+        3. FAIL, count = 0
+        4. FAIL, null array
+
+    bool dyn_array_extract_n(dyn_array_t *const dyn_array, const size_t index, const size_t count, void *const objects);
+        1. NORMAL, with destructor, assert not destructed
+        2. FAIL, range past the end (including a count that wraps index + count)
+        3. FAIL, count = 0
+        4. FAIL, null array/objects
+
+    bool dyn_array_append(dyn_array_t *const dst, const dyn_array_t *const src);
+        1. NORMAL, contents
+        2. NORMAL, empty src
+        3. NORMAL, dst == src
+        4. FAIL, data size mismatch
+        5. FAIL, null dst/src
+        6. FAIL, past max capacity
+
+    dyn_array_t *dyn_array_create_flags(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *),
+                                        const DYN_CREATE_FLAGS flags);
+        SEE INIT
+        1. FAIL, unknown flags
+        2. NORMAL, DYN_CREATE_RING, every other function above works the same on a ring:
+            a. push/pop/extract front and back across the wrap
+            b. at/front/back/for_each while wrapped
+            c. growing while wrapped
+            d. insert/erase/extract in the middle while wrapped
+            e. sort, bsearch, export while wrapped
+            f. append to and from a wrapped ring
+            g. clear and destroy destruct everything exactly once
+        3. NORMAL, DYN_CREATE_INLINE:
+            a. capacity taken as is (0 is 16), objects right after the struct
+            b. outgrowing it moves to the heap, contents intact
+            c. inline ring, wrapped, then outgrowing it
+            d. shrink_to_fit and reserve move back inline, never below the inline capacity
+            e. clear and destroy destruct everything exactly once
+        4. FAIL, inline capacity > DYN_MAX_CAPACITY
+
+    bool dyn_array_reserve(dyn_array_t *const dyn_array, const size_t capacity);
+        1. NORMAL, grows to exactly capacity
+        2. NORMAL, capacity <= current capacity, nothing changes
+        3. NORMAL, wrapped ring keeps its order
+        4. FAIL, capacity > DYN_MAX_CAPACITY
+        5. FAIL, null array
+
+    bool dyn_array_shrink_to_fit(dyn_array_t *const dyn_array);
+        1. NORMAL, capacity = size, contents intact, can still grow afterwards
+        2. NORMAL, empty, capacity = 1
+        3. NORMAL, wrapped ring keeps its order
+        4. FAIL, null array
+
+    bool dyn_array_set_growth(dyn_array_t *const dyn_array, const DYN_GROWTH_POLICY policy, const size_t amount);
+        1. NORMAL, factor (default doubles, 50% grows by half)
+        2. NORMAL, chunk (whole chunks, enough for a bulk insert)
+        3. NORMAL, exact
+        4. NORMAL, growth never passes DYN_MAX_CAPACITY
+        5. FAIL, factor/chunk with amount 0, factor > 1000, unknown policy
+        6. FAIL, null array
+
+    size_t dyn_array_remove_if(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                               void *const context);
+        1. NORMAL, matches removed, the rest keep their order, each removed one destructed once, count returned
+        2. NORMAL, nothing matches, everything matches, empty
+        3. NORMAL, wrapped ring
+        4. FAIL, null array/predicate
+
+    size_t dyn_array_partition(dyn_array_t *const dyn_array, bool (*predicate)(const void *const, void *const),
+                               void *const context);
+        1. NORMAL, trues first, nothing lost or destructed, count returned, predicate called once per object
+        2. NORMAL, nothing matches, everything matches, empty
+        3. NORMAL, wrapped ring
+        4. FAIL, null array/predicate
+
+    DYN_ARRAY_DEFINE(name, type, cmp) (dyn_array_typed.h, no NULL checks, so no FAIL cases)
+        1. NORMAL, name_create makes an array of type, the generic API sees the same objects
+        2. NORMAL, push/pop/extract front and back on plain and wrapped ring arrays, growing goes out of line
+        3. NORMAL, at/front/back, NULL when empty or out of range
+        4. NORMAL, pop with a destructor destructs
+        5. NORMAL, sort is stable, matches the generic sort, ring, empty fails, function or macro comparator
+        6. NORMAL, lower_bound/bsearch agree with the generic ones
 */
 
 // Shamelessly stolen from
@@ -220,6 +335,39 @@ int block_compare(const void *const a, const void *const b) {
     return ((int)(((const uint8_t *)a)[0])) - (((const uint8_t *)b)[0]);
 }
 
+// True if the block is one of the block numbers in context
+int predicate_counter = 0;
+bool block_in(const void *const block, void *const blocks) {
+    ++predicate_counter;
+    for (const char *number = (const char *) blocks; *number; ++number) {
+        if (((const uint8_t *)block)[0] == DATA_BLOCKS[*number - '0'][0]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// For the typed functions, key is what gets sorted, order is where it started (to check stability)
+typedef struct {
+    uint32_t key;
+    uint32_t order;
+} typed_pair_t;
+
+int typed_pair_compare(const void *const a, const void *const b) {
+    const uint32_t a_key = ((const typed_pair_t *)a)->key, b_key = ((const typed_pair_t *)b)->key;
+    return (a_key > b_key) - (a_key < b_key);
+}
+
+int typed_pair_compare_full(const void *const a, const void *const b) {
+    const int keys = typed_pair_compare(a, b);
+    return keys ? keys : (int)((const typed_pair_t *)a)->order - (int)((const typed_pair_t *)b)->order;
+}
+
+#define typed_pair_compare_inv(a, b) typed_pair_compare(b, a)
+
+DYN_ARRAY_DEFINE(typed_pair, typed_pair_t, typed_pair_compare)
+DYN_ARRAY_DEFINE_SORTED(typed_pair_inv, typed_pair_t, typed_pair_compare_inv)
+
 int block_compare_inv(const void *const a, const void *const b) {
     return ((int)(((const uint8_t *)b)[0])) - (((const uint8_t *)a)[0]);
 }
@@ -248,6 +396,27 @@ void run_basic_tests_d();
 // SORT and INSERT_SORTED
 void run_basic_tests_e();
 
+// LOWER_BOUND, UPPER_BOUND, BSEARCH, EQUAL_RANGE
+void run_basic_tests_f();
+
+// INSERT_N, PUSH_BACK_N, ERASE_N, EXTRACT_N, APPEND
+void run_basic_tests_g();
+
+// CREATE_FLAGS, RING
+void run_basic_tests_h();
+
+// RESERVE, SHRINK_TO_FIT, SET_GROWTH
+void run_basic_tests_i();
+
+// INLINE
+void run_basic_tests_j();
+
+// REMOVE_IF, PARTITION
+void run_basic_tests_k();
+
+// TYPED
+void run_basic_tests_l();
+
 void run_tests() {
     init_data_blocks();
 
@@ -266,6 +435,27 @@ void run_tests() {
     // SORT INSERT_SORTED
     run_basic_tests_e();
 
+    // LOWER_BOUND UPPER_BOUND BSEARCH EQUAL_RANGE
+    run_basic_tests_f();
+
+    // INSERT_N PUSH_BACK_N ERASE_N EXTRACT_N APPEND
+    run_basic_tests_g();
+
+    // CREATE_FLAGS RING
+    run_basic_tests_h();
+
+    // RESERVE SHRINK_TO_FIT SET_GROWTH
+    run_basic_tests_i();
+
+    // INLINE
+    run_basic_tests_j();
+
+    // REMOVE_IF, PARTITION
+    run_basic_tests_k();
+
+    // TYPED
+    run_basic_tests_l();
+
     puts("TESTS COMPLETE");
 }
 
@@ -1126,3 +1316,658 @@ void run_basic_tests_e() {
 
     dyn_array_destroy(dyn_a);
 }
+
+void run_basic_tests_f() {
+
+    dyn_array_t *dyn_a = NULL;
+    size_t first = 0, last = 0;
+
+    assert((dyn_a = dyn_array_create(0, DATA_BLOCK_SIZE, NULL)));
+
+    // LOWER_BOUND 2, UPPER_BOUND 2
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[2], &block_compare) == 0);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[2], &block_compare) == 0);
+
+    // 0x11 0x22 0x22 0x22 0x44 0x55
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[4], &block_compare));
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[1], &block_compare));
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[0], &block_compare));
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[3], &block_compare));
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[1], &block_compare));
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[1], &block_compare));
+    assert(dyn_array_size(dyn_a) == 6);
+    for (size_t idx = 1; idx < dyn_array_size(dyn_a); ++idx) {
+        assert(block_compare(dyn_array_at(dyn_a, idx - 1), dyn_array_at(dyn_a, idx)) <= 0);
+    }
+
+    // LOWER_BOUND 1, UPPER_BOUND 1
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[0], &block_compare) == 0);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[0], &block_compare) == 1);
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[1], &block_compare) == 1);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[1], &block_compare) == 4);
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[2], &block_compare) == 4);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[2], &block_compare) == 4);
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[4], &block_compare) == 5);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[4], &block_compare) == 6);
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[5], &block_compare) == 6);
+
+    // LOWER_BOUND 3, 4, 5, UPPER_BOUND 3, 4, 5
+    assert(dyn_array_lower_bound(NULL, DATA_BLOCKS[1], &block_compare) == SIZE_MAX);
+    assert(dyn_array_lower_bound(dyn_a, NULL, &block_compare) == SIZE_MAX);
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[1], NULL) == SIZE_MAX);
+    assert(dyn_array_upper_bound(NULL, DATA_BLOCKS[1], &block_compare) == SIZE_MAX);
+    assert(dyn_array_upper_bound(dyn_a, NULL, &block_compare) == SIZE_MAX);
+    assert(dyn_array_upper_bound(dyn_a, DATA_BLOCKS[1], NULL) == SIZE_MAX);
+
+    // BSEARCH 1
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[1], &block_compare) == dyn_array_at(dyn_a, 1));
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[4], &block_compare) == dyn_array_back(dyn_a));
+
+    // BSEARCH 2
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[2], &block_compare) == NULL);
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[5], &block_compare) == NULL);
+
+    // BSEARCH 3
+    assert(dyn_array_bsearch(NULL, DATA_BLOCKS[1], &block_compare) == NULL);
+    assert(dyn_array_bsearch(dyn_a, NULL, &block_compare) == NULL);
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[1], NULL) == NULL);
+
+    // EQUAL_RANGE 1
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[1], &block_compare, &first, &last));
+    assert(first == 1 && last == 4);
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[3], &block_compare, &first, &last));
+    assert(first == 4 && last == 5);
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[2], &block_compare, &first, &last));
+    assert(first == 4 && last == 4);
+
+    // EQUAL_RANGE 2
+    assert(dyn_array_equal_range(NULL, DATA_BLOCKS[1], &block_compare, &first, &last) == false);
+    assert(dyn_array_equal_range(dyn_a, NULL, &block_compare, &first, &last) == false);
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[1], NULL, &first, &last) == false);
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[1], &block_compare, NULL, &last) == false);
+    assert(dyn_array_equal_range(dyn_a, DATA_BLOCKS[1], &block_compare, &first, NULL) == false);
+
+    dyn_array_destroy(dyn_a);
+}
+
+// Checks the first byte of every object against a string of block numbers
+bool blocks_match(const dyn_array_t *const dyn_array, const char *const blocks) {
+    if (dyn_array_size(dyn_array) != strlen(blocks)) {
+        return false;
+    }
+    for (size_t idx = 0; blocks[idx]; ++idx) {
+        if (((uint8_t *)dyn_array_at(dyn_array, idx))[0] != DATA_BLOCKS[blocks[idx] - '0'][0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void run_basic_tests_g() {
+
+    dyn_array_t *dyn_a = NULL, *dyn_b = NULL;
+    uint8_t extracted[3][DATA_BLOCK_SIZE];
+
+    assert((dyn_a = dyn_array_create(0, DATA_BLOCK_SIZE, &block_destructor)));
+
+    // INSERT_N 1 (empty)
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[1], 2));
+    assert(blocks_match(dyn_a, "12"));
+
+    // INSERT_N 1 (front, back, arbitrary)
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[4], 2));
+    assert(blocks_match(dyn_a, "4512"));
+    assert(dyn_array_insert_n(dyn_a, 4, DATA_BLOCKS[0], 1));
+    assert(blocks_match(dyn_a, "45120"));
+    assert(dyn_array_insert_n(dyn_a, 2, DATA_BLOCKS[2], 3));
+    assert(blocks_match(dyn_a, "45234120"));
+
+    // INSERT_N 3, 4, 5
+    assert(dyn_array_insert_n(dyn_a, 10, DATA_BLOCKS[0], 1) == false);
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[0], 0) == false);
+    assert(dyn_array_insert_n(dyn_a, 0, NULL, 1) == false);
+    assert(dyn_array_insert_n(NULL, 0, DATA_BLOCKS[0], 1) == false);
+    assert(blocks_match(dyn_a, "45234120"));
+
+    // PUSH_BACK_N
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(blocks_match(dyn_a, "45234120012345"));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 0) == false);
+    assert(dyn_array_push_back_n(dyn_a, NULL, 1) == false);
+    assert(dyn_array_push_back_n(NULL, DATA_BLOCKS[0], 1) == false);
+
+    // INSERT_N 2 (16 -> 32)
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[3], 3));
+    assert(dyn_array_capacity(dyn_a) == 32);
+    assert(blocks_match(dyn_a, "45234120012345345"));
+
+    // EXTRACT_N 1
+    destruct_counter = 0;
+    assert(dyn_array_extract_n(dyn_a, 14, 3, extracted));
+    assert(destruct_counter == 0);
+    assert(extracted[0][0] == DATA_BLOCKS[3][0] && extracted[2][0] == DATA_BLOCKS[5][0]);
+    assert(blocks_match(dyn_a, "45234120012345"));
+
+    // EXTRACT_N 2, 3, 4
+    assert(dyn_array_extract_n(dyn_a, 12, 3, extracted) == false);
+    assert(dyn_array_extract_n(dyn_a, 0, 0, extracted) == false);
+    assert(dyn_array_extract_n(dyn_a, 0, 1, NULL) == false);
+    assert(dyn_array_extract_n(NULL, 0, 1, extracted) == false);
+    assert(dyn_array_extract_n(dyn_a, 1, SIZE_MAX, extracted) == false);
+    assert(blocks_match(dyn_a, "45234120012345"));
+
+    // ERASE_N 1 (arbitrary, front, back)
+    assert(dyn_array_erase_n(dyn_a, 2, 3));
+    assert(destruct_counter == 3);
+    assert(blocks_match(dyn_a, "45120012345"));
+    assert(dyn_array_erase_n(dyn_a, 0, 2));
+    assert(blocks_match(dyn_a, "120012345"));
+    assert(dyn_array_erase_n(dyn_a, 4, 5));
+    assert(destruct_counter == 10);
+    assert(blocks_match(dyn_a, "1200"));
+
+    // ERASE_N 2, 3, 4
+    assert(dyn_array_erase_n(dyn_a, 2, 3) == false);
+    assert(dyn_array_erase_n(dyn_a, 4, 1) == false);
+    assert(dyn_array_erase_n(dyn_a, 0, 0) == false);
+    assert(dyn_array_erase_n(NULL, 0, 1) == false);
+    assert(dyn_array_erase_n(dyn_a, 1, SIZE_MAX) == false);
+    assert(destruct_counter == 10);
+    assert(blocks_match(dyn_a, "1200"));
+
+    // APPEND 1
+    assert((dyn_b = dyn_array_create(0, DATA_BLOCK_SIZE, NULL)));
+    assert(dyn_array_push_back_n(dyn_b, DATA_BLOCKS[2], 2));
+    assert(dyn_array_append(dyn_a, dyn_b));
+    assert(blocks_match(dyn_a, "120023"));
+    assert(blocks_match(dyn_b, "23"));
+
+    // APPEND 2
+    dyn_array_clear(dyn_b);
+    assert(dyn_array_append(dyn_a, dyn_b));
+    assert(blocks_match(dyn_a, "120023"));
+
+    // APPEND 3 (6 -> 12 -> 24 -> 48, grows every time)
+    assert(dyn_array_append(dyn_a, dyn_a));
+    assert(dyn_array_append(dyn_a, dyn_a));
+    assert(dyn_array_append(dyn_a, dyn_a));
+    assert(blocks_match(dyn_a, "120023120023120023120023120023120023120023120023"));
+
+    // APPEND 5
+    assert(dyn_array_append(NULL, dyn_a) == false);
+    assert(dyn_array_append(dyn_a, NULL) == false);
+
+    // APPEND 6, INSERT_N 6
+    assert(dyn_array_append(dyn_a, dyn_a) == false);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], DYN_MAX_CAPACITY - 47) == false);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], SIZE_MAX) == false);
+    assert(dyn_array_insert_n(dyn_a, 1, DATA_BLOCKS[0], SIZE_MAX) == false);
+    assert(dyn_array_size(dyn_a) == 48);
+    assert(dyn_array_capacity(dyn_a) <= DYN_MAX_CAPACITY);
+
+    dyn_array_destroy(dyn_b);
+
+    // APPEND 4
+    assert((dyn_b = dyn_array_create(0, 1, NULL)));
+    assert(dyn_array_push_back(dyn_b, DATA_BLOCKS[0]));
+    assert(dyn_array_append(dyn_a, dyn_b) == false);
+    dyn_array_destroy(dyn_b);
+
+    destruct_counter = 0;
+    dyn_array_destroy(dyn_a);
+    assert(destruct_counter == 48);
+}
+
+void run_basic_tests_h() {
+
+    dyn_array_t *dyn_a = NULL, *dyn_b = NULL;
+    uint8_t extracted[3][DATA_BLOCK_SIZE];
+
+    // CREATE_FLAGS 1
+    assert(dyn_array_create_flags(0, DATA_BLOCK_SIZE, NULL, (DYN_CREATE_FLAGS) 0x04) == NULL);
+    assert(dyn_array_create_flags(DYN_MAX_CAPACITY + 1, DATA_BLOCK_SIZE, NULL, DYN_CREATE_RING) == NULL);
+    assert(dyn_array_create_flags(0, 0, NULL, DYN_CREATE_RING) == NULL);
+
+    assert((dyn_a = dyn_array_create_flags(0, DATA_BLOCK_SIZE, &block_destructor_mini, DYN_CREATE_RING)));
+    assert(dyn_array_capacity(dyn_a) == 16);
+
+    // RING a (the front goes round the back of the buffer straight away)
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[1]));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[2]));
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[3], 3));
+    assert(blocks_match(dyn_a, "345012"));
+
+    // RING b
+    assert(((uint8_t *)dyn_array_front(dyn_a))[0] == DATA_BLOCKS[3][0]);
+    assert(((uint8_t *)dyn_array_back(dyn_a))[0] == DATA_BLOCKS[2][0]);
+    assert(dyn_array_at(dyn_a, 6) == NULL);
+    for_each_counter = 0;
+    assert(dyn_array_for_each(dyn_a, &block_for_each));
+    assert(for_each_counter == 6);
+
+    destruct_counter = 0;
+    assert(dyn_array_pop_front(dyn_a));
+    assert(destruct_counter == 1);
+    assert(dyn_array_extract_front(dyn_a, extracted[0]));
+    assert(extracted[0][0] == DATA_BLOCKS[4][0]);
+    assert(dyn_array_extract_back(dyn_a, extracted[0]));
+    assert(extracted[0][0] == DATA_BLOCKS[2][0]);
+    assert(destruct_counter == 1);
+    assert(blocks_match(dyn_a, "501"));
+
+    // RING c (13 free slots, so 13 more fill it and the 14th grows it with the front wrapped)
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[0], 6));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[5]));
+    assert(dyn_array_capacity(dyn_a) == 16);
+    assert(blocks_match(dyn_a, "5012345501012345"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[2]));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[4]));
+    assert(dyn_array_capacity(dyn_a) == 32);
+    assert(blocks_match(dyn_a, "250123455010123454"));
+
+    // RING d
+    assert(dyn_array_pop_front(dyn_a) && dyn_array_pop_front(dyn_a));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[3]));
+    assert(dyn_array_insert(dyn_a, 2, DATA_BLOCKS[5]));
+    assert(blocks_match(dyn_a, "305123455010123454"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_erase_n(dyn_a, 3, 4));
+    assert(blocks_match(dyn_a, "030455010123454"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[2]));
+    assert(dyn_array_extract_n(dyn_a, 5, 3, extracted));
+    assert(extracted[0][0] == DATA_BLOCKS[5][0] && extracted[2][0] == DATA_BLOCKS[0][0]);
+    assert(blocks_match(dyn_a, "2030410123454"));
+
+    // RING e
+    assert(dyn_array_pop_front(dyn_a) && dyn_array_push_front(dyn_a, DATA_BLOCKS[1]));
+    assert(dyn_array_sort(dyn_a, &block_compare));
+    assert(blocks_match(dyn_a, "0001112334445"));
+    assert(dyn_array_pop_front(dyn_a) && dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_bsearch(dyn_a, DATA_BLOCKS[4], &block_compare) == dyn_array_at(dyn_a, 9));
+    assert(dyn_array_lower_bound(dyn_a, DATA_BLOCKS[5], &block_compare) == 12);
+    assert(dyn_array_insert_sorted(dyn_a, DATA_BLOCKS[2], &block_compare));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    const uint8_t *exported = dyn_array_export(dyn_a);
+    assert(exported == dyn_array_front(dyn_a));
+    for (size_t idx = 0; idx < dyn_array_size(dyn_a); ++idx) {
+        assert(exported + (idx * DATA_BLOCK_SIZE) == dyn_array_at(dyn_a, idx));
+    }
+    assert(blocks_match(dyn_a, "000011122334445"));
+
+    // RING f
+    assert((dyn_b = dyn_array_create_flags(0, DATA_BLOCK_SIZE, NULL, DYN_CREATE_RING)));
+    assert(dyn_array_push_back_n(dyn_b, DATA_BLOCKS[2], 2));
+    assert(dyn_array_push_front(dyn_b, DATA_BLOCKS[1]));
+    assert(dyn_array_append(dyn_a, dyn_b));
+    assert(blocks_match(dyn_a, "000011122334445123"));
+    assert(dyn_array_append(dyn_b, dyn_b));
+    assert(dyn_array_append(dyn_b, dyn_a));
+    assert(blocks_match(dyn_b, "123123000011122334445123"));
+
+    // RING g
+    destruct_counter = 0;
+    dyn_array_clear(dyn_a);
+    assert(destruct_counter == 18);
+    assert(dyn_array_empty(dyn_a));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[3]));
+    assert(blocks_match(dyn_a, "3"));
+    destruct_counter = 0;
+    dyn_array_destroy(dyn_a);
+    assert(destruct_counter == 1);
+    dyn_array_destroy(dyn_b);
+}
+
+void run_basic_tests_i() {
+
+    dyn_array_t *dyn_a = NULL;
+
+    assert((dyn_a = dyn_array_create(0, DATA_BLOCK_SIZE, NULL)));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+
+    // RESERVE 1, 2
+    assert(dyn_array_reserve(dyn_a, 21));
+    assert(dyn_array_capacity(dyn_a) == 21);
+    assert(dyn_array_reserve(dyn_a, 17));
+    assert(dyn_array_capacity(dyn_a) == 21);
+    assert(blocks_match(dyn_a, "012345"));
+
+    // RESERVE 4, 5
+    assert(dyn_array_reserve(dyn_a, DYN_MAX_CAPACITY + 1) == false);
+    assert(dyn_array_reserve(NULL, 20) == false);
+    assert(dyn_array_capacity(dyn_a) == 21);
+
+    // SHRINK_TO_FIT 1
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(dyn_array_capacity(dyn_a) == 6);
+    assert(blocks_match(dyn_a, "012345"));
+
+    // SET_GROWTH 1 (default still doubles)
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[5]));
+    assert(dyn_array_capacity(dyn_a) == 12);
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_FACTOR, 50));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(dyn_array_capacity(dyn_a) == 18);
+    assert(blocks_match(dyn_a, "0123455012345"));
+
+    // SET_GROWTH 2
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_CHUNK, 4));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(dyn_array_capacity(dyn_a) == 22);
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[0], 4));
+    assert(dyn_array_capacity(dyn_a) == 26);
+
+    // SET_GROWTH 3
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_EXACT, 0));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 5));
+    assert(dyn_array_capacity(dyn_a) == 28);
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_capacity(dyn_a) == 29);
+
+    // SET_GROWTH 4
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_FACTOR, 1000));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_capacity(dyn_a) == DYN_MAX_CAPACITY);
+    assert(dyn_array_size(dyn_a) == 30);
+
+    // SET_GROWTH 5, 6
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_FACTOR, 0) == false);
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_FACTOR, 1001) == false);
+    assert(dyn_array_set_growth(dyn_a, DYN_GROW_CHUNK, 0) == false);
+    assert(dyn_array_set_growth(dyn_a, (DYN_GROWTH_POLICY) 0x03, 1) == false);
+    assert(dyn_array_set_growth(NULL, DYN_GROW_EXACT, 0) == false);
+
+    // SHRINK_TO_FIT 2, 4
+    dyn_array_clear(dyn_a);
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(dyn_array_capacity(dyn_a) == 1);
+    assert(dyn_array_shrink_to_fit(NULL) == false);
+
+    dyn_array_destroy(dyn_a);
+
+    // RESERVE 3, SHRINK_TO_FIT 3
+    assert((dyn_a = dyn_array_create_flags(0, DATA_BLOCK_SIZE, NULL, DYN_CREATE_RING)));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[3], 3));
+    assert(dyn_array_insert_n(dyn_a, 0, DATA_BLOCKS[0], 3));
+    assert(dyn_array_reserve(dyn_a, 40));
+    assert(blocks_match(dyn_a, "012345"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[5]));
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(dyn_array_capacity(dyn_a) == 7);
+    assert(blocks_match(dyn_a, "5012345"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[4]));
+    assert(blocks_match(dyn_a, "45012345"));
+
+    dyn_array_destroy(dyn_a);
+}
+
+void run_basic_tests_j() {
+    dyn_array_t *dyn_a = NULL;
+
+    // CREATE_FLAGS 4
+    assert(dyn_array_create_flags(DYN_MAX_CAPACITY + 1, DATA_BLOCK_SIZE, NULL, DYN_CREATE_INLINE) == NULL);
+    assert(dyn_array_create_flags(0, 0, NULL, DYN_CREATE_INLINE) == NULL);
+
+    // INLINE a
+    assert((dyn_a = dyn_array_create_flags(0, DATA_BLOCK_SIZE, NULL, DYN_CREATE_INLINE)));
+    assert(dyn_array_capacity(dyn_a) == 16);
+    assert(DYN_IS_INLINE(dyn_a));
+    dyn_array_destroy(dyn_a);
+
+    assert((dyn_a = dyn_array_create_flags(3, DATA_BLOCK_SIZE, &block_destructor, DYN_CREATE_INLINE)));
+    assert(dyn_array_capacity(dyn_a) == 3);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 3));
+    assert(dyn_array_front(dyn_a) == DYN_INLINE_STORAGE(dyn_a));
+    assert(blocks_match(dyn_a, "012"));
+
+    // INLINE b
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[3]));
+    assert(!DYN_IS_INLINE(dyn_a));
+    assert(dyn_array_capacity(dyn_a) == 6);
+    assert(blocks_match(dyn_a, "0123"));
+    assert(dyn_array_insert(dyn_a, 1, DATA_BLOCKS[5]));
+    assert(blocks_match(dyn_a, "05123"));
+
+    // INLINE d
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(!DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 5);
+    destruct_counter = 0;
+    assert(dyn_array_erase_n(dyn_a, 1, 2));
+    assert(destruct_counter == 2);
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 3);
+    assert(blocks_match(dyn_a, "023"));
+    assert(dyn_array_reserve(dyn_a, 5));
+    assert(!DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 5);
+    assert(dyn_array_pop_back(dyn_a));
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 3);
+    assert(blocks_match(dyn_a, "02"));
+    assert(dyn_array_pop_back(dyn_a));
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 3);
+
+    // INLINE e
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[1], 4));
+    destruct_counter = 0;
+    dyn_array_clear(dyn_a);
+    assert(destruct_counter == 5);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[1], 2));
+    destruct_counter = 0;
+    dyn_array_destroy(dyn_a);
+    assert(destruct_counter == 2);
+
+    // INLINE c
+    assert((dyn_a = dyn_array_create_flags(4, DATA_BLOCK_SIZE, &block_destructor_mini,
+                                           DYN_CREATE_RING | DYN_CREATE_INLINE)));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[2]));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[3]));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[1]));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(DYN_IS_INLINE(dyn_a) && dyn_a->head);
+    assert(blocks_match(dyn_a, "0123"));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[4]));
+    assert(!DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 8);
+    assert(blocks_match(dyn_a, "01234"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[5]));
+    assert(dyn_array_pop_front(dyn_a));
+    assert(dyn_array_pop_front(dyn_a));
+    assert(dyn_a->head);
+    assert(dyn_array_shrink_to_fit(dyn_a));
+    assert(DYN_IS_INLINE(dyn_a) && dyn_array_capacity(dyn_a) == 4);
+    assert(blocks_match(dyn_a, "1234"));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(blocks_match(dyn_a, "01234"));
+    destruct_counter = 0;
+    dyn_array_destroy(dyn_a);
+    assert(destruct_counter == 5);
+}
+
+void run_basic_tests_k() {
+    dyn_array_t *dyn_a = NULL;
+
+    assert((dyn_a = dyn_array_create(0, DATA_BLOCK_SIZE, &block_destructor_mini)));
+
+    // REMOVE_IF 2
+    assert(dyn_array_remove_if(dyn_a, &block_in, "0") == 0);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 4));
+    assert(dyn_array_remove_if(dyn_a, &block_in, "") == 0);
+    assert(blocks_match(dyn_a, "0123450123"));
+
+    // REMOVE_IF 1
+    destruct_counter = 0;
+    predicate_counter = 0;
+    assert(dyn_array_remove_if(dyn_a, &block_in, "13") == 4);
+    assert(destruct_counter == 4 && predicate_counter == 10);
+    assert(blocks_match(dyn_a, "024502"));
+    assert(dyn_array_remove_if(dyn_a, &block_in, "4") == 1);
+    assert(blocks_match(dyn_a, "02502"));
+
+    // REMOVE_IF 4
+    assert(dyn_array_remove_if(NULL, &block_in, "0") == 0);
+    assert(dyn_array_remove_if(dyn_a, NULL, "0") == 0);
+
+    // REMOVE_IF 2
+    destruct_counter = 0;
+    assert(dyn_array_remove_if(dyn_a, &block_in, "025") == 5);
+    assert(destruct_counter == 5 && dyn_array_empty(dyn_a));
+
+    // PARTITION 2
+    assert(dyn_array_partition(dyn_a, &block_in, "0") == 0);
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 6));
+    assert(dyn_array_partition(dyn_a, &block_in, "") == 0);
+    assert(dyn_array_partition(dyn_a, &block_in, "012345") == 6);
+    assert(blocks_match(dyn_a, "012345"));
+
+    // PARTITION 1
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[0], 4));
+    destruct_counter = 0;
+    predicate_counter = 0;
+    assert(dyn_array_partition(dyn_a, &block_in, "13") == 4);
+    assert(destruct_counter == 0 && predicate_counter == 10);
+    assert(blocks_match(dyn_a, "3113450220"));
+
+    // PARTITION 4
+    assert(dyn_array_partition(NULL, &block_in, "0") == 0);
+    assert(dyn_array_partition(dyn_a, NULL, "0") == 0);
+
+    dyn_array_destroy(dyn_a);
+
+    // REMOVE_IF 3
+    assert((dyn_a = dyn_array_create_flags(0, DATA_BLOCK_SIZE, &block_destructor_mini, DYN_CREATE_RING)));
+    assert(dyn_array_push_back_n(dyn_a, DATA_BLOCKS[2], 4));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[1]));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[5]));
+    destruct_counter = 0;
+    assert(dyn_array_remove_if(dyn_a, &block_in, "05") == 3);
+    assert(destruct_counter == 3);
+    assert(blocks_match(dyn_a, "1234"));
+
+    // PARTITION 3
+    assert(dyn_array_push_front(dyn_a, DATA_BLOCKS[0]));
+    assert(dyn_array_pop_back(dyn_a));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[4]));
+    assert(dyn_array_push_back(dyn_a, DATA_BLOCKS[5]));
+    assert(dyn_a->head);
+    assert(blocks_match(dyn_a, "012345"));
+    assert(dyn_array_partition(dyn_a, &block_in, "024") == 3);
+    assert(blocks_match(dyn_a, "042315"));
+
+    dyn_array_destroy(dyn_a);
+}
+
+void run_basic_tests_l() {
+    dyn_array_t *dyn_a = NULL, *dyn_b = NULL;
+    typed_pair_t pair = {0, 0};
+
+    // TYPED 1, 3
+    assert((dyn_a = typed_pair_create(0, NULL, DYN_CREATE_DEFAULT)));
+    assert(dyn_array_data_size(dyn_a) == sizeof(typed_pair_t));
+    assert(typed_pair_front(dyn_a) == NULL && typed_pair_back(dyn_a) == NULL && typed_pair_at(dyn_a, 0) == NULL);
+    assert(typed_pair_extract_back(dyn_a, &pair) == false);
+    assert(typed_pair_pop_front(dyn_a) == false);
+
+    // TYPED 5
+    assert(typed_pair_sort(dyn_a) == false);
+
+    // TYPED 2
+    for (uint32_t idx = 0; idx < 40; ++idx) {
+        pair.key = idx % 7;
+        pair.order = idx;
+        assert(typed_pair_push_back(dyn_a, pair));
+    }
+    assert(dyn_array_size(dyn_a) == 40 && dyn_array_capacity(dyn_a) == 64);
+
+    // TYPED 1, 3
+    for (uint32_t idx = 0; idx < 40; ++idx) {
+        assert(typed_pair_at(dyn_a, idx) == dyn_array_at(dyn_a, idx));
+        assert(typed_pair_at(dyn_a, idx)->order == idx);
+    }
+    assert(typed_pair_at(dyn_a, 40) == NULL);
+    assert(typed_pair_front(dyn_a)->order == 0 && typed_pair_back(dyn_a)->order == 39);
+
+    // TYPED 2
+    pair.order = 100;
+    assert(typed_pair_push_front(dyn_a, pair));
+    assert(typed_pair_front(dyn_a)->order == 100 && dyn_array_size(dyn_a) == 41);
+    assert(typed_pair_extract_front(dyn_a, &pair) && pair.order == 100);
+    assert(typed_pair_extract_back(dyn_a, &pair) && pair.order == 39);
+    assert(typed_pair_pop_back(dyn_a) && typed_pair_back(dyn_a)->order == 37);
+    assert(typed_pair_pop_front(dyn_a) && typed_pair_front(dyn_a)->order == 1);
+    assert(dyn_array_size(dyn_a) == 37);
+
+    // TYPED 5
+    assert((dyn_b = dyn_array_create(0, sizeof(typed_pair_t), NULL)));
+    assert(dyn_array_append(dyn_b, dyn_a));
+    assert(typed_pair_sort(dyn_a));
+    assert(dyn_array_sort(dyn_b, &typed_pair_compare_full));
+    for (uint32_t idx = 0; idx < 37; ++idx) {
+        assert(memcmp(typed_pair_at(dyn_a, idx), dyn_array_at(dyn_b, idx), sizeof(typed_pair_t)) == 0);
+    }
+
+    // TYPED 6
+    for (pair.key = 0; pair.key < 8; ++pair.key) {
+        const size_t position = typed_pair_lower_bound(dyn_a, &pair);
+        assert(position == dyn_array_lower_bound(dyn_a, &pair, &typed_pair_compare));
+        assert(typed_pair_bsearch(dyn_a, &pair) == dyn_array_bsearch(dyn_a, &pair, &typed_pair_compare));
+    }
+    pair.key = 7;
+    assert(typed_pair_bsearch(dyn_a, &pair) == NULL && typed_pair_lower_bound(dyn_a, &pair) == 37);
+
+    dyn_array_destroy(dyn_a);
+    dyn_array_destroy(dyn_b);
+
+    // TYPED 2
+    assert((dyn_a = typed_pair_create(4, &block_destructor_mini, DYN_CREATE_RING | DYN_CREATE_INLINE)));
+    for (uint32_t idx = 0; idx < 3; ++idx) {
+        pair.order = idx;
+        assert(typed_pair_push_front(dyn_a, pair));
+    }
+    pair.order = 3;
+    assert(typed_pair_push_back(dyn_a, pair));
+    assert(dyn_a->head && DYN_IS_INLINE(dyn_a));
+    assert(typed_pair_front(dyn_a)->order == 2 && typed_pair_back(dyn_a)->order == 3);
+    assert(typed_pair_at(dyn_a, 1)->order == 1 && typed_pair_at(dyn_a, 2)->order == 0);
+    pair.order = 4;
+    assert(typed_pair_push_front(dyn_a, pair));
+    assert(!DYN_IS_INLINE(dyn_a) && dyn_array_size(dyn_a) == 5);
+    assert(typed_pair_extract_front(dyn_a, &pair) && pair.order == 4);
+    assert(typed_pair_extract_back(dyn_a, &pair) && pair.order == 3);
+
+    // TYPED 4
+    destruct_counter = 0;
+    assert(typed_pair_pop_front(dyn_a) && typed_pair_front(dyn_a)->order == 1);
+    assert(typed_pair_pop_back(dyn_a) && typed_pair_back(dyn_a)->order == 1);
+    assert(destruct_counter == 2);
+    assert(typed_pair_extract_front(dyn_a, &pair) && pair.order == 1);
+    assert(dyn_array_empty(dyn_a) && dyn_a->head == 0);
+
+    // TYPED 5 (ring, and the macro comparator)
+    for (uint32_t idx = 0; idx < 40; ++idx) {
+        pair.key = idx % 5;
+        pair.order = idx;
+        assert(idx & 1 ? typed_pair_push_back(dyn_a, pair) : typed_pair_push_front(dyn_a, pair));
+    }
+    assert(dyn_a->head);
+    // Stable, so equal keys stay in the order they were in: evens (pushed on the front) high to low, then odds
+    assert(typed_pair_inv_sort(dyn_a));
+    for (uint32_t idx = 1; idx < 40; ++idx) {
+        const typed_pair_t *const before = typed_pair_at(dyn_a, idx - 1), *const after = typed_pair_at(dyn_a, idx);
+        assert(before->key >= after->key);
+        if (before->key == after->key) {
+            switch ((before->order & 1) | ((after->order & 1) << 1)) {
+                case 0: assert(before->order > after->order); break;
+                case 1: assert(false); break;
+                case 2: break;
+                case 3: assert(before->order < after->order); break;
+            }
+        }
+    }
+
+    destruct_counter = 0;
+    dyn_array_destroy(dyn_a);
+    assert(destruct_counter == 40);
+}
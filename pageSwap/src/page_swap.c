@@ -6,6 +6,7 @@
 
 
 #include <dyn_array.h>
+#include <dyn_array_typed.h>
 #include <block_store.h>
 
 #include "../include/page_swap.h"
@@ -18,6 +19,9 @@ static PageTable_t pageTable;
 static dyn_array_t* frameIdxList;
 static block_store_t* blockStore;
 
+//typed access for the uint32_t arrays (the frame list and the page requests)
+DYN_ARRAY_DEFINE_ACCESS(uint32_array, uint32_t)
+
 /*
  * CLEARS THE PAGE TABLE AND FRAME TABLE WITH ALL ZEROS
  **/
@@ -34,7 +38,8 @@ void destroy_back_store(void) {
 }
 //init frameIdxList of which will tell us the LRU page
 bool initailize_frame_list(void) {
-	frameIdxList = dyn_array_create(512,sizeof(unsigned int),NULL);
+	//ring buffer, every reference pushes on the front
+	frameIdxList = uint32_array_create(512,NULL,DYN_CREATE_RING);
 	if (!frameIdxList) {
 		return false;
 	}
@@ -146,21 +151,28 @@ dyn_array_t* read_page_requests ( const char* const filename) {
 		close(fd);
 		return NULL;
 	}
-	//dyn_array for the page Request
-	dyn_array_t* page_Req = dyn_array_create(numReq, sizeof(unsigned int), NULL);
-	uint32_t page = 0;
-	int i = 0;
-	//read from binary fill && push back on page_Req
-	for(i = 0; i < numReq; ++i){
-		if(!(read(fd, &page, sizeof(uint32_t)))){//Error check 
+	//dyn_array for the page Request, sized exactly (create would round numReq up to a power of two)
+	dyn_array_t* page_Req = uint32_array_create(0, NULL, DYN_CREATE_DEFAULT);
+	if(!page_Req || !dyn_array_reserve(page_Req, numReq)){
+		dyn_array_destroy(page_Req);
+		close(fd);
+		return NULL;
+	}
+	//read from binary file a buffer at a time && push back the whole buffer on page_Req
+	uint32_t pages[1024];
+	size_t remaining = numReq;
+	while(remaining){
+		const size_t wanted = remaining < 1024 ? remaining : 1024;
+		const ssize_t got = read(fd, pages, wanted * sizeof(uint32_t));
+		//Error check, a short file or a read that ends mid request is as bad as a failed one
+		if(got <= 0 || got % sizeof(uint32_t) || !(dyn_array_push_back_n(page_Req, pages, got / sizeof(uint32_t)))){
+			dyn_array_destroy(page_Req);
 			close(fd);
 			return NULL;
 		}
-		if(!(dyn_array_push_back(page_Req, &page))){//Error check
-		   close(fd);
-		   return NULL;
-		}		
+		remaining -= got / sizeof(uint32_t);
 	}
+	close(fd);
 	return page_Req;
 }
 
@@ -179,7 +191,7 @@ bool initialize (void) {
 	/* Fill the entire Frame Table with correct values*/
 	for ( int i = 0; i < 512; ++i ) {
 		frameTable.entries[i].pageTableIdx = i;
-	 	if( !(dyn_array_push_front(frameIdxList, &i)) )
+	 	if( !(uint32_array_push_front(frameIdxList, i)) )
 			/*throw error*/
 			return false;
 		(frameTable.size)++;	
@@ -211,10 +223,10 @@ bool extract_pushBack_frameIdxList(const uint32_t frameNum)
 	uint32_t* frameIdx = NULL;
 
 	for( int i = 0; i < 512; ++i ) {
-		frameIdx = (uint32_t*)dyn_array_at(frameIdxList, i);
+		frameIdx = uint32_array_at(frameIdxList, i);
 		if( frameNum == *frameIdx ) {
 			dyn_array_extract(frameIdxList, i, &buffer);
-			dyn_array_push_front(frameIdxList, &buffer); //push_front(...), which in this case is really the back, 	
+			uint32_array_push_front(frameIdxList, buffer); //push_front(...), which in this case is really the back, 	
 			break;
 		}
 	}
@@ -225,9 +237,9 @@ bool extract_pushBack_frameIdxList(const uint32_t frameNum)
 //  this is poping off of front such that frameIdx will use to reference to the Least Recently Used page
 uint32_t extractVictim_pushBack_frameIdxList()
 {
-	uint32_t buffer;
-	dyn_array_extract_back(frameIdxList, &buffer);
-	dyn_array_push_front(frameIdxList, &buffer);
+	uint32_t buffer = 0;
+	uint32_array_extract_back(frameIdxList, &buffer);
+	uint32_array_push_front(frameIdxList, buffer);
 	return buffer;
 }
 //set page to invalid (no longer in memory)...page that is swapped out
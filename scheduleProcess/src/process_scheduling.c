@@ -9,6 +9,12 @@
 
 #include "../include/process_scheduling.h"
 #include <dyn_array.h>
+#include <dyn_array_typed.h>
+
+//typed access to the PCB arrays, and the two sorts (compare and compareBurstTime are declared in process_scheduling.h)
+DYN_ARRAY_DEFINE_ACCESS(pcb, ProcessControlBlock_t)
+DYN_ARRAY_DEFINE_SORTED(pcb_arrival, ProcessControlBlock_t, compare)
+DYN_ARRAY_DEFINE_SORTED(pcb_burst, ProcessControlBlock_t, compareBurstTime)
 
 
 const ScheduleStats_t first_come_first_served(dyn_array_t* futureProcesses) {
@@ -21,7 +27,8 @@ const ScheduleStats_t first_come_first_served(dyn_array_t* futureProcesses) {
 		return stats;
 	}
 	//create readyQ, counter for completed processes, time counter, PCB_t to hold running Process
-	dyn_array_t* readyQ = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+	//ring buffer, so taking from the front (and fetching onto it) is cheap every tick
+	dyn_array_t* readyQ = pcb_create(0, NULL, DYN_CREATE_RING | DYN_CREATE_INLINE);
 	size_t procDone = 0;
 	size_t timer = 0;
 	ProcessControlBlock_t runningProcess;
@@ -47,7 +54,7 @@ const ScheduleStats_t first_come_first_served(dyn_array_t* futureProcesses) {
 				stats.averageLatencyTime += timer;
 			}
 			//error check for extract_front function; we are extracting new/first process from readyQ
-			if(!dyn_array_extract_front(readyQ, &runningProcess))
+			if(!pcb_extract_front(readyQ, &runningProcess))
 				break;
 		}
 		//if readyQ is not empty or the running time of current process is greater than zero continue throwing current processes
@@ -75,7 +82,8 @@ const ScheduleStats_t shortest_job_first(dyn_array_t* futureProcesses) {
 	if(!futureProcesses || dyn_array_empty(futureProcesses)){
 		return stats;
 	}
-	dyn_array_t* readyQ = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+	//ring buffer, so taking from the front (and fetching onto it) is cheap every tick
+	dyn_array_t* readyQ = pcb_create(0, NULL, DYN_CREATE_RING | DYN_CREATE_INLINE);
 	size_t procDone = 0;
 	size_t timer = 0;
 	ProcessControlBlock_t runningProcess;
@@ -88,7 +96,7 @@ const ScheduleStats_t shortest_job_first(dyn_array_t* futureProcesses) {
 			//if fetch_process fetchs process, adding to the readyQ, we need to 
 			// sort readyQ by burstTime of process
 			if(fetch_new_processes(readyQ, futureProcesses, timer)){
-				dyn_array_sort(readyQ, &compareBurstTime);
+				pcb_burst_sort(readyQ);
 			}
 		}
 		//if timer==zero && dyn_array_empty(readyQ) not empty then need to extract from front of readyQ
@@ -104,7 +112,7 @@ const ScheduleStats_t shortest_job_first(dyn_array_t* futureProcesses) {
 				stats.averageLatencyTime += timer;			
 			}
 			//error check for extract_front function; we are extracting new/first process from readyQ
-			if(!dyn_array_extract_front(readyQ, &runningProcess)){
+			if(!pcb_extract_front(readyQ, &runningProcess)){
 				break;
 			}
 		}
@@ -162,7 +170,7 @@ const bool create_suspended_processes_and_assign_pcbs(dyn_array_t* futureProcess
 			// Any value greater than zero signals that we are the parent process
 			else if(pid > 0) {
 				// Assign pid to PCB 
-				ProcessControlBlock_t* pcb = dyn_array_at(futureProcesses, i);
+				ProcessControlBlock_t* pcb = pcb_at(futureProcesses, i);
 				pcb->pid = pid;
 				kill(pcb->pid, SIGSTOP); // Suspend child process
 			}
@@ -178,35 +186,25 @@ const bool fetch_new_processes(dyn_array_t* newProcesses, dyn_array_t* futurePro
 	if(!futureProcesses || !newProcesses){
 		return false;
 	}
-	//create incrementer, counter of processes moved from fp to np, PCB to look and extract
-	int i =0, counter = 0;
-	ProcessControlBlock_t* backFp;
-	ProcessControlBlock_t newPCB;
 	//get size of fp and sort fp by arrival time 
 	size_t fpSize = dyn_array_size(futureProcesses);
+	if(fpSize == 0){
+		return true;//nothing left to move, nothing went wrong
+	}
 	rearranged_process_control_blocks_by_arrival_time(futureProcesses);
-	//loop through fp, moving PCBs with less than or equal to currentClockTime
-	for(i=0; i < fpSize; i++){
-		//looking at back of dyn checking the arrival time
-		backFp = dyn_array_back(futureProcesses);
-		if(backFp->arrivalTime <= currentClockTime){
-			//error check extract back
-			if(!dyn_array_extract_back(futureProcesses, &newPCB))
-				return false;
-			if(dyn_array_push_front(newProcesses, &newPCB))
-				++counter;//incrementer here to state that we have moved at least one PCB from fp to np
-		}
-		//if counter is zero == we have not moved at least one taking into account they are sorted by arrivalTime this guarantees no PCB eligible to be added
-		if(counter == 0){
-			return false;
-		}
-		//if this statement is true there are no more PCB in fp to move to np, such break out of current loop to return true meaning that we moved at least one PCB from fp
-		// to np
-		if (counter < i){
-			break;
-		}
+	//sorted latest arrival first, so the eligible PCBs are a run at the back of fp, count them
+	size_t counter = 0;
+	while(counter < fpSize && pcb_at(futureProcesses, fpSize - counter - 1)->arrivalTime <= currentClockTime){
+		++counter;
+	}
+	//if counter is zero no PCB is eligible to be added
+	if(counter == 0){
+		return false;
 	}
-	return true;
+	//move the whole run in one go, it lands on the front of np in the same order it had at the back of fp
+	//the sort left fp in one piece, so the run can be copied straight out of it (fp has no destructor, erasing just drops them)
+	return dyn_array_insert_n(newProcesses, 0, pcb_at(futureProcesses, fpSize - counter), counter) &&
+		   dyn_array_erase_n(futureProcesses, fpSize - counter, counter);
 }
 
 void virtual_cpu(ProcessControlBlock_t* runningProcess) {
@@ -244,6 +242,8 @@ const bool load_process_control_blocks_from_file(dyn_array_t* futureProcesses, c
 				size_t i = 0;
 				// create PCB_t buffer, reading each PCB && inserting them into futureProcesses, continuing with for(...) loop
 				ProcessControlBlock_t data;
+				//make room for all of them up front, just a hint (the inserts still grow it if this fails)
+				dyn_array_reserve(futureProcesses, dyn_array_size(futureProcesses) + numBlocks);
 				for(i = 0; i < numBlocks; ++i) 
 				{
 					if(read(fd, &data, sizeof(ProcessControlBlock_t))) 
@@ -282,7 +282,7 @@ const bool rearranged_process_control_blocks_by_arrival_time(dyn_array_t* future
 		return false;
 	}
 	// Sort futureProcess by arrivalTime returning results validity 
-	if(dyn_array_sort(futureProcesses, &compare))
+	if(pcb_arrival_sort(futureProcesses))
 		return true;
 	else {
 		fprintf(stderr,"\nsort function error\n");
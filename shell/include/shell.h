@@ -16,6 +16,7 @@
 #include <stdbool.h>
 
 #include <dyn_array.h>
+#include <dyn_arena.h>
 
 // Struct to hold parsed user commands
 typedef struct {
@@ -97,6 +98,15 @@ void child_worker(int fd, int col_key, int shmId);
 ///
 dyn_array_t* tokenizer (const char* str, const char* delims);
 
+///
+/// String -> tokens -> dyn_array, without the heap
+/// \param str c-string to tokenize (1024 char max)
+/// \parm delims c-string of delimiters
+/// \param arena arena the copy of str and the array come from (reset it to free them)
+/// \return dyn_array of tokens as c-strings (pointing into the arena), NULL on error
+///
+dyn_array_t* tokenizer_arena (const char* str, const char* delims, dyn_arena_t* arena);
+
 void dyn_tok_destruct(void *tok_str);
 
 #endif
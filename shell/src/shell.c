@@ -353,10 +353,18 @@ void child_worker(int fd, int col_key, int shmId){
 		return;
 	}
 
+	// Arena for the tokens, reset every line so parsing a line never touches the heap
+	dyn_arena_t* arena = dyn_arena_create(0);
+	if(!arena){
+		perror("Error dyn_arena_create(): ");
+		return;
+	}
+
 	// Read each line in given file, tokenize it, and copy it into shared memory
 	while(!feof(fp)){
 		fgets(buffer, 1024, fp);
-		toker = tokenizer(buffer, ",""\n");
+		dyn_arena_reset(arena); // Done with the last line's tokens
+		toker = tokenizer_arena(buffer, ",""\n", arena);
 		if(dyn_array_size(toker) >= col_key){
 			//fprintf(stdout, "\tBefore: shm: %s\n", *index);
 			//shm = *(char**)dyn_array_at(toker, col_key-1);
@@ -375,7 +383,7 @@ void child_worker(int fd, int col_key, int shmId){
 	shmdt((void *)shm); // Detach shared memory segment	
 	fclose(fp); // close file stream
 	close(fd); // close file descriptor
- 	dyn_tok_destruct(toker); // Destroy tokenizer array
+ 	dyn_arena_destroy(arena); // Destroy tokenizer arrays (all of them at once)
 	_exit(0); // Exit successfully
 }
 
@@ -392,7 +400,7 @@ dyn_array_t *tokenizer(const char *str, const char *delims) {
     if (str && delims) {
         char *str_copy = strndup(str, MAX_BUFFER_RD_SIZE); // buffer created will be 1024+terminator
         if (str_copy) {
-            strings = dyn_array_create(16, sizeof(char *), &dyn_tok_destruct);
+            strings = dyn_array_create_flags(16, sizeof(char *), &dyn_tok_destruct, DYN_CREATE_INLINE);
             if (strings) {
                 char *tok_pos = strtok_r(str_copy, delims, &strtok_pos);
                 while (tok_pos != NULL) {
@@ -413,4 +421,31 @@ dyn_array_t *tokenizer(const char *str, const char *delims) {
         }
     }
     return strings;
-}
\ No newline at end of file
+}
+
+dyn_array_t *tokenizer_arena(const char *str, const char *delims, dyn_arena_t *arena) {
+    // Same as tokenizer, but everything comes from the arena: one copy of the line and the array
+    // The tokens just point into the copy (strtok_r already cut it up), so they need no destructor
+    dyn_array_t *strings = NULL;
+    char *strtok_pos = NULL;
+    if (str && delims && arena) {
+        const size_t length = strnlen(str, MAX_BUFFER_RD_SIZE);
+        char *str_copy = (char *) dyn_arena_alloc(arena, length + 1);
+        if (str_copy) {
+            memcpy(str_copy, str, length);
+            str_copy[length] = '\0';
+            strings = dyn_array_create_with_allocator(16, sizeof(char *), NULL, DYN_CREATE_INLINE, dyn_arena_allocator(arena));
+            if (strings) {
+                char *tok_pos = strtok_r(str_copy, delims, &strtok_pos);
+                while (tok_pos != NULL) {
+                    if (!dyn_array_push_back(strings, &tok_pos)) {
+                        strings = NULL; // Nothing to clean up, the arena has it
+                        break;
+                    }
+                    tok_pos = strtok_r(NULL, delims, &strtok_pos);
+                }
+            }
+        }
+    }
+    return strings;
+}